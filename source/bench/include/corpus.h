@@ -0,0 +1,30 @@
+#ifndef INCLUDE_GUARD__CORPUS_H__GUID_b3e91d04c7a24f58a61e2d9f0c85b7a6
+#define INCLUDE_GUARD__CORPUS_H__GUID_b3e91d04c7a24f58a61e2d9f0c85b7a6
+
+#include <string>
+#include <cstddef>
+
+/**
+ * @brief Kinds of synthetic texts used by the benchmarks.
+ */
+enum class corpus_profile_e {
+    prose,          //!< English prose without any textual number.
+    numbers,        //!< Textual numbers separated by single spaces or punctuation.
+    whitespace,     //!< Words separated by long runs of whitespace.
+    utf8,           //!< Text mostly formed by multi-byte UTF-8 code points, with some numbers.
+    log,            //!< Log lines with some numbers, every line ends with punctuation.
+    count_          //!< Number of profiles, not a profile.
+};
+
+/// Returns the name of `profile`, as reported in the results.
+const char* corpus_profile_name(corpus_profile_e profile) noexcept;
+
+/**
+ * @brief Generates a text of `profile` of about `size` bytes.
+ *
+ * The text only depends on its arguments, so that different runs of the
+ * benchmarks can be compared.
+ */
+std::string make_corpus(corpus_profile_e profile, std::size_t size) noexcept;
+
+#endif // INCLUDE_GUARD__CORPUS_H__GUID_b3e91d04c7a24f58a61e2d9f0c85b7a6
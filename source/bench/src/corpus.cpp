@@ -0,0 +1,140 @@
+#include "corpus.h"
+
+#include <random>
+#include <array>
+
+namespace {
+
+    const std::array<const char*, 24> prose_words = {{
+        "the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog", "while",
+        "nobody", "was", "looking", "at", "river", "bank", "and", "it", "rained",
+        "during", "whole", "afternoon", "of", "that", "summer"
+    }};
+
+    const std::array<const char*, 12> utf8_words = {{
+        "栗林", "将軍", "の", "言葉", "は", "明確", "だった",
+        "привет", "мир", "café", "naïve", "Straße"
+    }};
+
+    const std::array<const char*, 10> digits = {{
+        "zero", "one", "two", "three", "four", "five", "six", "seven", "eight", "nine"
+    }};
+
+    const std::array<const char*, 10> teens = {{
+        "ten", "eleven", "twelve", "thirteen", "fourteen",
+        "fifteen", "sixteen", "seventeen", "eighteen", "nineteen"
+    }};
+
+    const std::array<const char*, 10> tens = {{
+        "", "", "twenty", "thirty", "forty", "fifty", "sixty", "seventy", "eighty", "ninety"
+    }};
+
+    /// Appends the words of 0 < `n` < 1000.
+    void append_hundreds(std::string& out, unsigned n) noexcept
+    {
+        if (n >= 100) {
+            out += digits[n / 100];
+            out += " hundred";
+            n %= 100;
+            if (n == 0) return;
+            out += " and ";
+        }
+        if (n >= 20) {
+            out += tens[n / 10];
+            if (n % 10) {
+                out += '-';
+                out += digits[n % 10];
+            }
+        }
+        else if (n >= 10) {
+            out += teens[n - 10];
+        }
+        else {
+            out += digits[n];
+        }
+    }
+
+    /// Appends the words of `n` < 1000000000.
+    void append_number(std::string& out, unsigned n) noexcept
+    {
+        if (n == 0) {
+            out += "zero";
+            return;
+        }
+
+        bool first = true;
+        auto group = [&](unsigned value, const char* scale) {
+            if (!value) return;
+            if (!first) out += ' ';
+            append_hundreds(out, value);
+            if (*scale) {
+                out += ' ';
+                out += scale;
+            }
+            first = false;
+        };
+        group(n / 1000000, "million");
+        group(n / 1000 % 1000, "thousand");
+        group(n % 1000, "");
+    }
+}
+
+const char* corpus_profile_name(corpus_profile_e profile) noexcept
+{
+    switch (profile) {
+    case corpus_profile_e::prose:       return "prose";
+    case corpus_profile_e::numbers:     return "numbers";
+    case corpus_profile_e::whitespace:  return "whitespace";
+    case corpus_profile_e::utf8:        return "utf8";
+    case corpus_profile_e::log:         return "log";
+    default:                            return "unknown";
+    }
+}
+
+std::string make_corpus(corpus_profile_e profile, std::size_t size) noexcept
+{
+    std::mt19937 rng(static_cast<unsigned>(profile) + 1);
+    auto random = [&](unsigned n) { return static_cast<unsigned>(rng() % n); };
+
+    std::string out;
+    out.reserve(size + 256);
+    while (out.size() < size) {
+        switch (profile) {
+        case corpus_profile_e::prose:
+            out += prose_words[random(prose_words.size())];
+            out += random(12) == 0 ? ".\n" : random(8) == 0 ? ", " : " ";
+            break;
+
+        case corpus_profile_e::numbers:
+            append_number(out, random(4) == 0 ? random(1000000000) : random(1000));
+            out += random(4) == 0 ? ", " : " ";
+            break;
+
+        case corpus_profile_e::whitespace:
+            out += prose_words[random(prose_words.size())];
+            out.append(1 + random(64), ' ');
+            out.append(random(8), '\t');
+            out.append(random(4), '\n');
+            break;
+
+        case corpus_profile_e::log:
+            out += "request ";
+            out += prose_words[random(prose_words.size())];
+            out += " took ";
+            append_number(out, random(1000));
+            out += " ms after ";
+            append_number(out, random(10));
+            out += " retries, status ";
+            out += prose_words[random(prose_words.size())];
+            out += ".\n";
+            break;
+
+        default:
+            if (random(8) == 0) append_number(out, random(1000));
+            else                out += utf8_words[random(utf8_words.size())];
+            out += random(12) == 0 ? "。\n" : " ";
+            break;
+        }
+    }
+    return out;
+}
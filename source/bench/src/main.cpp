@@ -0,0 +1,299 @@
+#include "corpus.h"
+
+#include "core/char_class.h"
+#include "core/digitize.h"
+#include "core/grammar.h"
+#include "core/token_stream.h"
+
+#include "absl/strings/numbers.h"
+#include "absl/strings/string_view.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace {
+    using namespace core;
+
+    /// Stream buffer that discards everything, so that convert() is measured without the cost of any output.
+    class null_buffer_t : public std::streambuf {
+    protected:
+        int_type overflow(int_type c) override { return traits_type::not_eof(c); }
+        std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+    };
+
+    /// Stream buffer that reads from a text without copying it.
+    class view_buffer_t : public std::streambuf {
+    public:
+        explicit view_buffer_t(absl::string_view text) noexcept
+        {
+            auto p = const_cast<char*>(text.data());
+            setg(p, p, p + text.size());
+        }
+    };
+
+    using clock_type = std::chrono::steady_clock;
+
+    /// When each line is sent to and received from convert_interactive(), see bench_latency().
+    struct line_clock_t {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::vector<clock_type::time_point> sent;       //!< When each line is given to the input.
+        std::vector<clock_type::time_point> received;   //!< When each line is completed in the output.
+    };
+
+    /// Stream buffer that gives a text one line at a time, each once the previous one has been received.
+    class paced_input_t : public std::streambuf {
+    public:
+        paced_input_t(absl::string_view text, line_clock_t& clock) noexcept : text_(text), pos_(0), clock_(&clock) {}
+
+    protected:
+        int_type underflow() override
+        {
+            if (pos_ == text_.size()) return traits_type::eof();
+            auto end = text_.find('\n', pos_);
+            end = end == absl::string_view::npos ? text_.size() : end + 1;
+            {
+                // a line whose end is never written would stall the input, so do not wait forever
+                std::unique_lock<std::mutex> lock(clock_->mutex);
+                clock_->cv.wait_for(lock, std::chrono::seconds(1), [&]{ return clock_->received.size() >= clock_->sent.size(); });
+                clock_->sent.push_back(clock_type::now());
+            }
+            auto p = const_cast<char*>(text_.data());
+            setg(p + pos_, p + pos_, p + end);
+            pos_ = end;
+            return traits_type::to_int_type(*gptr());
+        }
+
+    private:
+        absl::string_view text_;
+        std::size_t pos_;
+        line_clock_t* clock_;
+    };
+
+    /// Stream buffer that discards everything, but records when each line is completed.
+    class timed_output_t : public std::streambuf {
+    public:
+        explicit timed_output_t(line_clock_t& clock) noexcept : clock_(&clock) {}
+
+    protected:
+        int_type overflow(int_type c) override
+        {
+            if (c == traits_type::to_int_type('\n')) receive(1);
+            return traits_type::not_eof(c);
+        }
+
+        std::streamsize xsputn(const char* s, std::streamsize n) override
+        {
+            receive(static_cast<std::size_t>(std::count(s, s + n, '\n')));
+            return n;
+        }
+
+    private:
+        void receive(std::size_t lines) noexcept
+        {
+            if (!lines) return;
+            auto now = clock_type::now();
+            {
+                std::lock_guard<std::mutex> lock(clock_->mutex);
+                clock_->received.insert(clock_->received.end(), lines, now);
+            }
+            clock_->cv.notify_all();
+        }
+
+        line_clock_t* clock_;
+    };
+
+    /// Measurement of a single benchmark.
+    struct result_t {
+        std::size_t tokens;     //!< Number of tokens processed on each repetition.
+        double seconds;         //!< Wall time of the fastest repetition.
+    };
+
+    /// Runs `fn`, which returns the number of processed tokens, `repeat` times and keeps the fastest one.
+    template<typename Fn>
+    result_t measure(std::size_t repeat, Fn fn) noexcept
+    {
+        result_t result = { 0, 0.0 };
+        for (std::size_t i = 0; i < repeat; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            auto tokens = fn();
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            if (i == 0 || elapsed.count() < result.seconds) result.seconds = elapsed.count();
+            result.tokens = tokens;
+        }
+        return result;
+    }
+
+    /// Iterates over all the tokens of `text`.
+    std::size_t bench_tokenize(absl::string_view text) noexcept
+    {
+        token_stream_t stream(text);
+        std::size_t tokens = 0;
+        for (auto it = stream.begin(); it != stream.end(); ++it) ++tokens;
+        return tokens;
+    }
+
+    /// Tries to match a textual number at every token of `text` that does not belong to a previous match.
+    std::size_t bench_match(absl::string_view text, grammar_engine_e engine) noexcept
+    {
+        token_stream_t stream(text, max_lookahead);
+        std::size_t tokens = 0;
+        auto it = stream.begin();
+        while (stream) {
+            auto m = match_cardinal_number(it.look_ahead(), engine);
+            auto n = m ? m.size : 1;
+            it += n;
+            tokens += n;
+        }
+        return tokens;
+    }
+
+    /// Converts `text` end to end, discarding the output.
+    std::size_t bench_convert(absl::string_view text, std::size_t tokens) noexcept
+    {
+        null_buffer_t buffer;
+        std::ostream os(&buffer);
+        convert(text, os);
+        return tokens;
+    }
+
+    /// Converts `text` end to end in interactive mode, discarding the output.
+    std::size_t bench_interactive(absl::string_view text, std::size_t tokens) noexcept
+    {
+        view_buffer_t in_buffer(text);
+        null_buffer_t out_buffer;
+        std::istream is(&in_buffer);
+        std::ostream os(&out_buffer);
+        convert_interactive(is, os);
+        return tokens;
+    }
+
+    /// Latency of the lines converted in interactive mode.
+    struct latency_t {
+        std::size_t lines;      //!< Number of lines measured.
+        double p50;             //!< Median latency in seconds.
+        double p99;             //!< 99th percentile of the latency in seconds.
+        double max;             //!< Maximum latency in seconds.
+    };
+
+    /**
+     * Measures the time from a line being available in the input of convert_interactive()
+     * until it is completed in its output, giving each line once the previous one has
+     * been written, as in a live pipe.
+     */
+    latency_t bench_latency(absl::string_view text, std::size_t max_lines) noexcept
+    {
+        std::size_t end = 0;
+        for (std::size_t i = 0; i != max_lines && end != text.size(); ++i) {
+            end = text.find('\n', end);
+            end = end == absl::string_view::npos ? text.size() : end + 1;
+        }
+
+        line_clock_t clock;
+        paced_input_t in_buffer(text.substr(0, end), clock);
+        timed_output_t out_buffer(clock);
+        std::istream is(&in_buffer);
+        std::ostream os(&out_buffer);
+        convert_interactive(is, os);
+
+        std::vector<double> latencies;
+        for (std::size_t i = 0; i != std::min(clock.sent.size(), clock.received.size()); ++i) {
+            std::chrono::duration<double> latency = clock.received[i] - clock.sent[i];
+            latencies.push_back(latency.count());
+        }
+        if (latencies.empty()) return { 0, 0.0, 0.0, 0.0 };
+
+        std::sort(latencies.begin(), latencies.end());
+        auto n = latencies.size();
+        return { n, latencies[n / 2], latencies[n * 99 / 100], latencies.back() };
+    }
+
+    void print_latency(std::ostream& os, corpus_profile_e profile, latency_t latency, bool last) noexcept
+    {
+        os << "    { \"profile\": \"" << corpus_profile_name(profile) << "\""
+           << ", \"benchmark\": \"interactive_latency\""
+           << ", \"lines\": " << latency.lines
+           << ", \"p50_us\": " << latency.p50 * 1e6
+           << ", \"p99_us\": " << latency.p99 * 1e6
+           << ", \"max_us\": " << latency.max * 1e6
+           << " }" << (last ? "\n" : ",\n");
+    }
+
+    void print_result(std::ostream& os, corpus_profile_e profile, const char* name, std::size_t bytes, result_t result, bool last) noexcept
+    {
+        auto seconds = std::max(result.seconds, 1e-9);
+        os << "    { \"profile\": \"" << corpus_profile_name(profile) << "\""
+           << ", \"benchmark\": \"" << name << "\""
+           << ", \"bytes\": " << bytes
+           << ", \"tokens\": " << result.tokens
+           << ", \"seconds\": " << result.seconds
+           << ", \"mb_per_s\": " << bytes / seconds / 1e6
+           << ", \"tokens_per_s\": " << result.tokens / seconds
+           << " }" << (last ? "\n" : ",\n");
+    }
+
+    void print_usage(std::ostream& os) noexcept
+    {
+        os << "Usage:\n"
+              "  bench [--size <MiB>] [--repeat <n>]\n\n"
+              "Description:\n"
+              "  Measures the throughput of tokenization, grammar matching and\n"
+              "  end to end conversion on synthetic texts of <MiB> MiB (defaults\n"
+              "  to 16), keeping the fastest of <n> repetitions (defaults to 3).\n"
+              "  The latency of interactive mode is measured on the lines of the\n"
+              "  log profile. Results are written as JSON to stdout.\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::size_t size_mib = 16;
+    std::size_t repeat = 3;
+    for (int i = 1; i < argc; ++i) {
+        absl::string_view arg = argv[i];
+        std::size_t* value = arg == "--size" ? &size_mib : arg == "--repeat" ? &repeat : nullptr;
+        if (!value || ++i == argc || !absl::SimpleAtoi(argv[i], value) || *value == 0) {
+            print_usage(std::cerr);
+            return EXIT_FAILURE;
+        }
+    }
+
+    auto& os = std::cout;
+    os << "{\n"
+       << "  \"char_class_isa\": \"" << char_class_isa_name(char_class_isa()) << "\",\n"
+       << "  \"repeat\": " << repeat << ",\n"
+       << "  \"results\": [\n";
+
+    for (int p = 0; p != static_cast<int>(corpus_profile_e::count_); ++p) {
+        auto profile = static_cast<corpus_profile_e>(p);
+        auto text = make_corpus(profile, size_mib * 1024 * 1024);
+        auto bytes = text.size();
+
+        auto tokenize = measure(repeat, [&]{ return bench_tokenize(text); });
+        auto automaton = measure(repeat, [&]{ return bench_match(text, grammar_engine_e::automaton); });
+        auto descent = measure(repeat, [&]{ return bench_match(text, grammar_engine_e::recursive_descent); });
+        auto end_to_end = measure(repeat, [&]{ return bench_convert(text, tokenize.tokens); });
+        auto interactive = measure(repeat, [&]{ return bench_interactive(text, tokenize.tokens); });
+
+        bool last = p + 1 == static_cast<int>(corpus_profile_e::count_);
+        print_result(os, profile, "tokenize", bytes, tokenize, false);
+        print_result(os, profile, "match_automaton", bytes, automaton, false);
+        print_result(os, profile, "match_recursive_descent", bytes, descent, false);
+        print_result(os, profile, "convert", bytes, end_to_end, false);
+        print_result(os, profile, "interactive", bytes, interactive, last && profile != corpus_profile_e::log);
+        if (profile == corpus_profile_e::log) print_latency(os, profile, bench_latency(text, 10000), last);
+        os << std::flush;
+    }
+
+    os << "  ]\n"
+       << "}\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,108 @@
+#ifndef INCLUDE_GUARD__WORDS2DIGITS_H__GUID_52cd593044674115bad57a1cc6f1b8e8
+#define INCLUDE_GUARD__WORDS2DIGITS_H__GUID_52cd593044674115bad57a1cc6f1b8e8
+
+/**
+ * @file
+ * @brief C interface of the words2digits shared library.
+ *
+ * Converts the textual numbers of in-memory buffers without spawning a process,
+ * e.g. from Go (cgo) or Python (ctypes). Only plain C types cross the interface,
+ * and the converter is an opaque handle, so the ABI does not depend on the C++
+ * implementation. Buffers are converted straight from memory to memory, without
+ * iostreams nor locales.
+ *
+ * Each converter keeps the storage of the tokens between calls, so converting
+ * many short texts with the same converter does not allocate in steady state.
+ * A converter must not be used by several threads at the same time, but
+ * different converters can be used concurrently, e.g. one per thread.
+ */
+
+#include <stddef.h>
+
+#if defined(_WIN32)
+#   if defined(W2D_BUILDING_LIBRARY)
+#       define W2D_API __declspec(dllexport)
+#   else
+#       define W2D_API __declspec(dllimport)
+#   endif
+#else
+#   define W2D_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Version of the interface, only incremented on incompatible changes.
+#define W2D_ABI_VERSION 1
+
+/// Result of the functions of the interface.
+typedef enum w2d_status {
+    W2D_OK = 0,                 //!< The function succeeded.
+    W2D_INVALID_ARGUMENT = 1,   //!< A required pointer was null.
+    W2D_BUFFER_TOO_SMALL = 2    //!< The output buffer cannot hold the converted text.
+} w2d_status;
+
+/// Opaque handle of a converter.
+typedef struct w2d_converter w2d_converter;
+
+/**
+ * @brief Returns the W2D_ABI_VERSION the library was built with.
+ *
+ * Callers that load the library dynamically should check it against the
+ * version of the header they were built with.
+ */
+W2D_API int w2d_abi_version(void);
+
+/**
+ * @brief Creates a converter.
+ *
+ * @returns The new converter, which must be destroyed with w2d_converter_destroy(),
+ *   or null if it could not be allocated.
+ */
+W2D_API w2d_converter* w2d_converter_create(void);
+
+/**
+ * @brief Destroys a converter created by w2d_converter_create().
+ *
+ * @param converter Converter to destroy, nothing is done if null.
+ */
+W2D_API void w2d_converter_destroy(w2d_converter* converter);
+
+/**
+ * @brief Returns the size of an output buffer that can hold the conversion of any
+ *        text of `input_size` characters.
+ *
+ * No textual number is shorter than its digits, so the converted text is never
+ * larger than the input, and this is simply `input_size`.
+ */
+W2D_API size_t w2d_output_bound(size_t input_size);
+
+/**
+ * @brief Replace each occurrance of a textual number in the input to digits and write
+ *        the modified text to the output buffer.
+ *
+ * When `output_capacity` is at least w2d_output_bound() of the input, the text is
+ * converted straight into `output`, which may even be `input` itself. Otherwise,
+ * the text is converted into storage of the converter and copied if it fits.
+ * The output buffer must not overlap the input, unless both start at the same address.
+ *
+ * @param converter Converter to use.
+ * @param input Input text, which may be null if `input_size` is 0.
+ * @param input_size Number of characters of the input.
+ * @param output Where the converted text is written, without a terminating null,
+ *   which may be null if `output_capacity` is 0.
+ * @param output_capacity Number of characters that can be written at `output`.
+ * @param output_size Where the size of the converted text is stored, also when
+ *   W2D_BUFFER_TOO_SMALL is returned, so that the call can be retried.
+ * @returns W2D_OK on success, W2D_BUFFER_TOO_SMALL if the converted text does not
+ *   fit in the output buffer, or W2D_INVALID_ARGUMENT if a required pointer is null.
+ */
+W2D_API w2d_status w2d_convert(w2d_converter* converter, const char* input, size_t input_size,
+                               char* output, size_t output_capacity, size_t* output_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCLUDE_GUARD__WORDS2DIGITS_H__GUID_52cd593044674115bad57a1cc6f1b8e8
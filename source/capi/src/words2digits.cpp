@@ -0,0 +1,59 @@
+#include "words2digits.h"
+
+#include "core/digitize.h"
+
+#include "absl/strings/string_view.h"
+
+#include <cstring>
+#include <new>
+#include <string>
+
+/// The converter behind the opaque handle of the interface.
+struct w2d_converter {
+    core::converter_t converter;    //!< Keeps the token storage between calls.
+    std::string scratch;            //!< Converted text when the output buffer may be too small.
+};
+
+int w2d_abi_version(void)
+{
+    return W2D_ABI_VERSION;
+}
+
+w2d_converter* w2d_converter_create(void)
+{
+    return new (std::nothrow) w2d_converter();
+}
+
+void w2d_converter_destroy(w2d_converter* converter)
+{
+    delete converter;
+}
+
+size_t w2d_output_bound(size_t input_size)
+{
+    return input_size;
+}
+
+w2d_status w2d_convert(w2d_converter* converter, const char* input, size_t input_size,
+                       char* output, size_t output_capacity, size_t* output_size)
+{
+    if (!converter || !output_size) return W2D_INVALID_ARGUMENT;
+    if (!input && input_size != 0) return W2D_INVALID_ARGUMENT;
+    if (!output && output_capacity != 0) return W2D_INVALID_ARGUMENT;
+
+    absl::string_view in(input, input_size);
+
+    // the converted text is never larger than the input, so it is written straight
+    // to the output when there is room for the whole input
+    if (output_capacity >= w2d_output_bound(input_size)) {
+        *output_size = input_size != 0 ? converter->converter.convert(in, output) : 0;
+        return W2D_OK;
+    }
+
+    auto& scratch = converter->scratch;
+    converter->converter.convert(in, scratch);
+    *output_size = scratch.size();
+    if (scratch.size() > output_capacity) return W2D_BUFFER_TOO_SMALL;
+    if (!scratch.empty()) std::memcpy(output, scratch.data(), scratch.size());
+    return W2D_OK;
+}
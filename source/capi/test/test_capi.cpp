@@ -0,0 +1,80 @@
+#include "unittest.h"
+
+#include "words2digits.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+struct test_capi : ::testing::Test {};
+
+TEST(test_capi, conformance)
+{
+    ASSERT_EQ(w2d_abi_version(), W2D_ABI_VERSION);
+
+    auto converter = w2d_converter_create();
+    ASSERT_NE(converter, nullptr);
+
+    std::string text = "She has forty-two dogs and a thousand cats.";
+    std::string out(w2d_output_bound(text.size()), '\0');
+    std::size_t size = 0;
+    ASSERT_EQ(w2d_convert(converter, text.data(), text.size(), &out[0], out.size(), &size), W2D_OK);
+    ASSERT_EQ(out.substr(0, size), "She has 42 dogs and 1000 cats.");
+
+    // the buffer can be converted over itself
+    ASSERT_EQ(w2d_convert(converter, &text[0], text.size(), &text[0], text.size(), &size), W2D_OK);
+    ASSERT_EQ(text.substr(0, size), "She has 42 dogs and 1000 cats.");
+
+    // empty texts do not need any buffer
+    ASSERT_EQ(w2d_convert(converter, nullptr, 0, nullptr, 0, &size), W2D_OK);
+    ASSERT_EQ(size, 0u);
+
+    ASSERT_EQ(w2d_convert(nullptr, "one", 3, &out[0], out.size(), &size), W2D_INVALID_ARGUMENT);
+    ASSERT_EQ(w2d_convert(converter, nullptr, 3, &out[0], out.size(), &size), W2D_INVALID_ARGUMENT);
+    ASSERT_EQ(w2d_convert(converter, "one", 3, &out[0], out.size(), nullptr), W2D_INVALID_ARGUMENT);
+
+    w2d_converter_destroy(converter);
+    w2d_converter_destroy(nullptr);
+}
+
+TEST(test_capi, small_buffer)
+{
+    auto converter = w2d_converter_create();
+
+    // the required size is reported when the output does not fit
+    std::string text = "one hundred and two";
+    char out[8];
+    std::size_t size = 0;
+    ASSERT_EQ(w2d_convert(converter, text.data(), text.size(), out, 2, &size), W2D_BUFFER_TOO_SMALL);
+    ASSERT_EQ(size, 3u);
+    ASSERT_EQ(w2d_convert(converter, text.data(), text.size(), out, size, &size), W2D_OK);
+    ASSERT_EQ(std::string(out, size), "102");
+
+    w2d_converter_destroy(converter);
+}
+
+TEST(test_capi, threads)
+{
+    std::string text, expected;
+    for (int i = 0; i < 100; ++i) {
+        text += "There are one hundred and twenty-three dogs, a thousand cats.\n";
+        expected += "There are 123 dogs, 1000 cats.\n";
+    }
+
+    // separate converters are used concurrently
+    std::vector<std::string> outs(4);
+    std::vector<std::thread> threads;
+    for (auto& out : outs) {
+        threads.emplace_back([&text, &out]() {
+            auto converter = w2d_converter_create();
+            std::string buffer(w2d_output_bound(text.size()), '\0');
+            std::size_t size = 0;
+            for (int i = 0; i < 50; ++i)
+                w2d_convert(converter, text.data(), text.size(), &buffer[0], buffer.size(), &size);
+            out = buffer.substr(0, size);
+            w2d_converter_destroy(converter);
+        });
+    }
+    for (auto& t : threads) t.join();
+    for (auto& out : outs) ASSERT_EQ(out, expected);
+}
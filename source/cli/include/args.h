@@ -1,17 +1,38 @@
 #ifndef INCLUDE_GUARD__ARGS_H__GUID_61e8c7f5f6f142508859d5a7a7bacdb4
 #define INCLUDE_GUARD__ARGS_H__GUID_61e8c7f5f6f142508859d5a7a7bacdb4
 
+#include "core/edits.h"
+#include "core/grammar.h"
+#include "core/records.h"
+
 #include "absl/types/optional.h"
 #include "absl/types/variant.h"
 
 #include <iosfwd>
 #include <string>
+#include <vector>
+#include <cstddef>
 
 /// Parsed arguments.
 struct args_t {
     bool overwrite;                         //!< Whether outfile can be overwritten.
     absl::optional<std::string> infile;     //!< Path to input file.
     absl::optional<std::string> outfile;    //!< Path to output file
+    std::size_t jobs;                       //!< Number of threads for mapped input, 0 for hardware threads.
+    bool pipeline;                          //!< Whether stream input is converted in pipelined stages.
+    std::size_t queue_depth;                //!< Maximum number of blocks between pipeline stages.
+    bool interactive;                       //!< Whether stream input is converted with bounded latency.
+    std::size_t max_hold;                   //!< Maximum time in milliseconds text is held in interactive mode.
+    bool stats;                             //!< Whether stats of the conversion are printed to err.
+    absl::optional<std::string> batch;      //!< Directory where the outputs are written in batch mode.
+    std::vector<std::string> inputs;        //!< Paths to the input files and directories of batch mode.
+    bool in_place;                          //!< Whether infile is converted over itself.
+    absl::optional<std::string> journal;    //!< Path to the journal of the in-place conversion.
+    absl::optional<std::string> serve;      //!< Path to the Unix domain socket where conversions are served.
+    absl::optional<core::record_fields_t> records; //!< Fields of the records that are converted in record mode.
+    absl::optional<core::edit_format_e> edits;     //!< Format of the edit script written instead of the converted text.
+    absl::optional<std::string> apply;      //!< Path to the edit script applied to infile.
+    core::grammar_variant_e grammar;        //!< Variant of the grammar that is matched.
 };
 
 /**
@@ -0,0 +1,25 @@
+#ifndef INCLUDE_GUARD__BATCH_H__GUID_0b99b14e1a844d2cbbf6c9707b3d241d
+#define INCLUDE_GUARD__BATCH_H__GUID_0b99b14e1a844d2cbbf6c9707b3d241d
+
+#include "args.h"
+
+#include <iosfwd>
+
+/**
+ * @brief Converts the files of batch mode (see args_t::batch).
+ *
+ * Every input file, and every regular file of an input directory, is converted to
+ * the file of the same name in the output directory. The files are converted by
+ * args_t::jobs threads, largest first, and the threads that run out of files steal
+ * them from the others (see core::run_tasks()). A file that cannot be converted is
+ * reported to `err`, but it does not stop the rest of the batch.
+ *
+ * @param args Parsed arguments, with args_t::batch set.
+ * @param in Stream where the input paths are read from, one per line, if
+ *  args_t::inputs is empty.
+ * @param err Stream where errors and stats are printed.
+ * @returns EXIT_SUCCESS if every file was converted, EXIT_FAILURE otherwise.
+ */
+int run_batch(const args_t& args, std::istream& in, std::ostream& err) noexcept;
+
+#endif // INCLUDE_GUARD__BATCH_H__GUID_0b99b14e1a844d2cbbf6c9707b3d241d
@@ -0,0 +1,72 @@
+#ifndef INCLUDE_GUARD__SERVE_H__GUID_c92085f43b2d45629f7b510f7903fc52
+#define INCLUDE_GUARD__SERVE_H__GUID_c92085f43b2d45629f7b510f7903fc52
+
+#include "args.h"
+
+#include "absl/strings/string_view.h"
+
+#include <iosfwd>
+#include <string>
+#include <cstddef>
+
+/**
+ * @brief Kinds of the frames of the serve protocol, see run_serve().
+ */
+enum class serve_frame_e : char {
+    convert = 'c',      //!< Request to convert the text of the payload.
+    stats = 's',        //!< Request of the counters and latency histogram of the server.
+    shutdown = 'q',     //!< Request to stop the server once the pending requests are served.
+    ok = 'k',           //!< Response with the result of the request.
+    error = 'e'         //!< Response with the reason why the request failed.
+};
+
+/// Maximum size of the payload of a frame, larger frames close the connection.
+constexpr std::size_t serve_max_payload = 64 * 1024 * 1024;
+
+/// Seconds a connection may stall in the middle of a frame before it is closed.
+constexpr int serve_timeout = 10;
+
+/**
+ * @brief Writes a frame of the serve protocol to socket `fd`.
+ *
+ * @returns Whether the whole frame was written.
+ */
+bool write_frame(int fd, serve_frame_e kind, absl::string_view payload) noexcept;
+
+/**
+ * @brief Reads a frame of the serve protocol from socket `fd`.
+ *
+ * @param fd Socket to read from.
+ * @param kind Where the kind of the frame is stored.
+ * @param payload String whose contents are replaced by the payload of the frame.
+ * @returns Whether a whole frame was read, false on end of file, errors or
+ *  payloads larger than serve_max_payload.
+ */
+bool read_frame(int fd, serve_frame_e& kind, std::string& payload) noexcept;
+
+/**
+ * @brief Serves conversions over a Unix domain socket (see args_t::serve).
+ *
+ * Clients send requests and receive their responses as frames: a byte with the
+ * kind of frame (see serve_frame_e), the size of the payload as 4 bytes in big
+ * endian, and the payload. Each connection may send any number of requests, one
+ * at a time, and many clients may be connected at once.
+ *
+ * A single thread waits for new connections and for requests on the idle ones, and
+ * hands the connections with a request to a fixed pool of args_t::jobs workers.
+ * Each worker keeps its own core::converter_t, while the grammar tables are shared
+ * by all of them, as they are immutable. The latency of each conversion, from the
+ * request being read to the response being ready, is added to a histogram that
+ * is returned by stats requests.
+ *
+ * The server stops on a shutdown request, SIGINT or SIGTERM, once the pending
+ * requests are served, and removes the socket.
+ *
+ * @param args Parsed arguments, with args_t::serve set.
+ * @param err Stream where errors and, with args_t::stats, the stats of all the
+ *  conversions are printed.
+ * @returns EXIT_SUCCESS if the server stopped on request, EXIT_FAILURE otherwise.
+ */
+int run_serve(const args_t& args, std::ostream& err) noexcept;
+
+#endif // INCLUDE_GUARD__SERVE_H__GUID_c92085f43b2d45629f7b510f7903fc52
@@ -1,10 +1,16 @@
 #include "args.h"
+#include "core/digitize.h"
+#include "core/grammar.h"
 
 #include "absl/strings/string_view.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
 
+#include <ostream>
 #include <cstdlib>
 #include <algorithm>
 #include <vector>
+#include <string>
 #include <iterator>
 
 namespace {
@@ -13,7 +19,19 @@ namespace {
         name.remove_prefix(std::distance(std::find_if(name.rbegin(), name.rend(), [](char c){ return c == '/' || c == '\\'; }), name.rend()));
         os <<
             "Usage:\n"
-            "  " << name << " [<input-file> [[--force|-f] <output-file>]]\n"
+            "  " << name << " [--stats] [--grammar <variant>] [--jobs|-j <n>]\n"
+            "  " << std::string(name.size(), ' ') << " [--pipeline|-p [--queue-depth <n>]]\n"
+            "  " << std::string(name.size(), ' ') << " [--interactive|-i [--max-hold <ms>]]\n"
+            "  " << std::string(name.size(), ' ') << " [<input-file> [[--force|-f] <output-file>]]\n"
+            "  " << name << " --in-place [--journal <path>] [--stats] <input-file>\n"
+            "  " << name << " --batch|-b <output-dir> [--stats] [--jobs|-j <n>] [--force|-f]\n"
+            "  " << std::string(name.size(), ' ') << " [<input>...]\n"
+            "  " << name << " --records <format> [--fields <list>] [--stats] [--jobs|-j <n>]\n"
+            "  " << std::string(name.size(), ' ') << " [<input-file> [[--force|-f] <output-file>]]\n"
+            "  " << name << " --edits <format> [--stats] [--jobs|-j <n>]\n"
+            "  " << std::string(name.size(), ' ') << " [<input-file> [[--force|-f] <output-file>]]\n"
+            "  " << name << " --apply <edit-script> [<input-file> [[--force|-f] <output-file>]]\n"
+            "  " << name << " --serve <socket> [--stats] [--jobs|-j <n>]\n"
             "  " << name << " [--help | -h]\n";
         os << std::flush;
     }
@@ -29,7 +47,60 @@ namespace {
             "  is supplied, writes to stdout. It will not replace the contents of\n"
             "  <output-file> unless '--force' or '-f' is supplied.\n"
             "  Use end of command options argument '--' (double-dash) to specify\n"
-            "  <input-file> and <output-file> paths that start with '-' (dash).\n";
+            "  <input-file> and <output-file> paths that start with '-' (dash).\n\n"
+            "  When <input-file> is a regular file, '--jobs <n>' or '-j <n>' converts\n"
+            "  it with <n> threads (0 means one per hardware thread). Defaults to 1.\n"
+            "  Otherwise, '--pipeline' or '-p' reads, converts and writes the text\n"
+            "  on separate threads, with at most '--queue-depth <n>' blocks waiting\n"
+            "  between them. Defaults to 8.\n\n"
+            "  For live pipes, '--interactive' or '-i' writes the text that cannot be\n"
+            "  part of a textual number as soon as it is read, and flushes the output\n"
+            "  at the end of each line. Text that may be part of a textual number is\n"
+            "  held for at most '--max-hold <ms>' milliseconds, defaults to 100.\n\n"
+            "  With '--in-place', <input-file> is converted over itself and then\n"
+            "  truncated, without a second file. An interrupted conversion leaves\n"
+            "  it partially converted, unless '--journal <path>' is supplied, in\n"
+            "  which case running the same command again resumes the conversion.\n\n"
+            "  With '--batch <output-dir>' or '-b <output-dir>', converts many files\n"
+            "  at once: each <input> file, and each regular file of an <input>\n"
+            "  directory, is converted to the file of the same name in <output-dir>,\n"
+            "  which is created if needed. If no <input> is supplied, their paths are\n"
+            "  read from stdin, one per line. Files are converted by '--jobs' threads,\n"
+            "  largest first, and the errors of a file do not stop the batch.\n\n"
+            "  With '--records <format>', the input is a file of records in <format>,\n"
+            "  either 'csv', 'tsv' or 'jsonl', and only the textual numbers of the\n"
+            "  fields in '--fields <list>' are converted, every other character is\n"
+            "  kept as is. <list> is a comma separated list of column numbers, from 1,\n"
+            "  for 'csv' and 'tsv', or of keys of the top-level objects, whose string\n"
+            "  values are converted, for 'jsonl'. Defaults to every field. Batches of\n"
+            "  records are converted by '--jobs' threads.\n\n"
+            "  With '--edits <format>', writes an edit script instead of the converted\n"
+            "  text, with the offset and length in bytes and the value of each textual\n"
+            "  number, either as 'binary' records or as 'jsonl' objects. The binary\n"
+            "  script starts with 'w2dedit1', followed by 32 bytes per textual number:\n"
+            "  its offset, length, value and flags as 8 bytes in little endian, where\n"
+            "  flag 1 means a newline is written before the digits. The jsonl script\n"
+            "  has a line such as {\"offset\":4,\"length\":9,\"value\":42} per textual\n"
+            "  number, with \"newline\":true if the flag is set.\n\n"
+            "  With '--apply <edit-script>', writes the text that results of applying\n"
+            "  the edit script, in either format, to <input-file>, which is the same\n"
+            "  as converting <input-file> if the script was written from it.\n\n"
+            "  With '--serve <socket>', stays resident and converts the texts sent\n"
+            "  by many clients over the Unix domain socket <socket>, with '--jobs'\n"
+            "  workers, until it is sent a shutdown request or SIGINT or SIGTERM.\n"
+            "  Requests and responses are frames of a byte with their kind, the size\n"
+            "  of their payload as 4 bytes in big endian, and the payload. Requests\n"
+            "  are 'c' to convert the payload, 's' for the counters and latency\n"
+            "  histogram of the server, and 'q' to shut it down. Responses are 'k'\n"
+            "  with the result, or 'e' with an error message.\n\n"
+            "  With '--stats', statistics of the conversion (counters of tokens and\n"
+            "  grammar rules, and the time spent on each stage) are printed to the\n"
+            "  standard error once finished.\n\n"
+            "  '--grammar <variant>' selects the variant of the grammar of textual\n"
+            "  numbers, in any mode. The variants are:";
+        for (std::size_t i = 0; i != static_cast<std::size_t>(core::grammar_variant_e::count_); ++i)
+            os << (i == 0 ? " " : ", ") << core::grammar_variant_name(static_cast<core::grammar_variant_e>(i));
+        os << ".\n  Defaults to '" << core::grammar_variant_name(core::default_grammar_variant) << "'.\n";
         os << std::flush;
     }
 }
@@ -37,28 +108,58 @@ namespace {
 absl::variant<int, args_t> parse_args(int argc, char const* const* argv, std::ostream& os, std::ostream& err) noexcept
 {
     std::vector<absl::string_view> args(std::next(argv), std::next(argv, argc));
+    absl::string_view name = argc > 0 ? argv[0] : "words2digits";
 
     args_t parsed_args;
     auto& overwrite = parsed_args.overwrite;
     auto& infile = parsed_args.infile;
     auto& outfile = parsed_args.outfile;
+    auto& jobs = parsed_args.jobs;
+    auto& pipeline = parsed_args.pipeline;
+    auto& queue_depth = parsed_args.queue_depth;
+    auto& interactive = parsed_args.interactive;
+    auto& max_hold = parsed_args.max_hold;
+    auto& stats = parsed_args.stats;
+    auto& batch = parsed_args.batch;
+    auto& inputs = parsed_args.inputs;
+    auto& in_place = parsed_args.in_place;
+    auto& journal = parsed_args.journal;
+    auto& serve = parsed_args.serve;
+    auto& records = parsed_args.records;
+    auto& edits = parsed_args.edits;
+    auto& apply = parsed_args.apply;
+    auto& grammar = parsed_args.grammar;
 
     bool help = false;
     overwrite = false;
     infile = absl::nullopt;
     outfile = absl::nullopt;
+    jobs = 1;
+    pipeline = false;
+    queue_depth = core::default_queue_depth;
+    interactive = false;
+    max_hold = static_cast<std::size_t>(core::default_max_hold.count());
+    stats = false;
+    batch = absl::nullopt;
+    inputs.clear();
+    in_place = false;
+    journal = absl::nullopt;
+    serve = absl::nullopt;
+    records = absl::nullopt;
+    absl::optional<absl::string_view> fields;
+    edits = absl::nullopt;
+    apply = absl::nullopt;
+    grammar = core::default_grammar_variant;
 
     bool end_optional = false;
 
-    for (auto& arg : args) {
+    // positional arguments are either the input and output files, or the inputs of batch mode
+    std::vector<absl::string_view> paths;
+
+    for (std::size_t i = 0; i < args.size(); ++i) {
+        auto arg = args[i];
         if (arg[0] != '-' || end_optional) {
-            if (outfile) {
-                err << "syntax error: too many arguments provided\n";
-                print_usage(args[0], err);
-                return EXIT_FAILURE;
-            }
-            if (infile) outfile.emplace(arg);
-            else        infile.emplace(arg);
+            paths.push_back(arg);
             continue;
         }
 
@@ -72,20 +173,228 @@ absl::variant<int, args_t> parse_args(int argc, char const* const* argv, std::os
             continue;
         }
 
+        if (arg == "--jobs" || arg == "-j") {
+            if (++i == args.size() || !absl::SimpleAtoi(args[i], &jobs)) {
+                err << "syntax error: option '" << arg << "' requires a number of jobs\n";
+                print_usage(name, err);
+                return EXIT_FAILURE;
+            }
+            continue;
+        }
+
+        if (arg == "--stats") {
+            stats = true;
+            continue;
+        }
+
+        if (arg == "--pipeline" || arg == "-p") {
+            pipeline = true;
+            continue;
+        }
+
+        if (arg == "--queue-depth") {
+            if (++i == args.size() || !absl::SimpleAtoi(args[i], &queue_depth) || queue_depth == 0) {
+                err << "syntax error: option '" << arg << "' requires a positive queue depth\n";
+                print_usage(name, err);
+                return EXIT_FAILURE;
+            }
+            continue;
+        }
+
+        if (arg == "--interactive" || arg == "-i") {
+            interactive = true;
+            continue;
+        }
+
+        if (arg == "--max-hold") {
+            if (++i == args.size() || !absl::SimpleAtoi(args[i], &max_hold)) {
+                err << "syntax error: option '" << arg << "' requires a time in milliseconds\n";
+                print_usage(name, err);
+                return EXIT_FAILURE;
+            }
+            continue;
+        }
+
+        if (arg == "--batch" || arg == "-b") {
+            if (++i == args.size()) {
+                err << "syntax error: option '" << arg << "' requires an output directory\n";
+                print_usage(name, err);
+                return EXIT_FAILURE;
+            }
+            batch.emplace(args[i]);
+            continue;
+        }
+
+        if (arg == "--in-place") {
+            in_place = true;
+            continue;
+        }
+
+        if (arg == "--journal") {
+            if (++i == args.size()) {
+                err << "syntax error: option '" << arg << "' requires a path\n";
+                print_usage(name, err);
+                return EXIT_FAILURE;
+            }
+            journal.emplace(args[i]);
+            continue;
+        }
+
+        if (arg == "--records") {
+            if (++i == args.size() || (args[i] != "csv" && args[i] != "tsv" && args[i] != "jsonl")) {
+                err << "syntax error: option '" << arg << "' requires a format, either 'csv', 'tsv' or 'jsonl'\n";
+                print_usage(name, err);
+                return EXIT_FAILURE;
+            }
+            records.emplace();
+            records->format = args[i] == "csv" ? core::record_format_e::csv :
+                              args[i] == "tsv" ? core::record_format_e::tsv : core::record_format_e::jsonl;
+            continue;
+        }
+
+        if (arg == "--fields") {
+            if (++i == args.size() || args[i].empty()) {
+                err << "syntax error: option '" << arg << "' requires a list of fields\n";
+                print_usage(name, err);
+                return EXIT_FAILURE;
+            }
+            fields = args[i];
+            continue;
+        }
+
+        if (arg == "--edits") {
+            if (++i == args.size() || (args[i] != "binary" && args[i] != "jsonl")) {
+                err << "syntax error: option '" << arg << "' requires a format, either 'binary' or 'jsonl'\n";
+                print_usage(name, err);
+                return EXIT_FAILURE;
+            }
+            edits = args[i] == "binary" ? core::edit_format_e::binary : core::edit_format_e::jsonl;
+            continue;
+        }
+
+        if (arg == "--apply") {
+            if (++i == args.size()) {
+                err << "syntax error: option '" << arg << "' requires a path\n";
+                print_usage(name, err);
+                return EXIT_FAILURE;
+            }
+            apply.emplace(args[i]);
+            continue;
+        }
+
+        if (arg == "--grammar") {
+            if (++i == args.size() || !core::find_grammar_variant(args[i], grammar)) {
+                err << "syntax error: option '" << arg << "' requires a variant of the grammar\n";
+                print_usage(name, err);
+                return EXIT_FAILURE;
+            }
+            continue;
+        }
+
+        if (arg == "--serve") {
+            if (++i == args.size()) {
+                err << "syntax error: option '" << arg << "' requires a socket path\n";
+                print_usage(name, err);
+                return EXIT_FAILURE;
+            }
+            serve.emplace(args[i]);
+            continue;
+        }
+
         if (arg == "--") {
             end_optional = true;
             continue;
         }
 
         err << "syntax error: unrecognized command option '" << arg << "'\n";
-        print_usage(args[0], err);
+        print_usage(name, err);
         return EXIT_FAILURE;
     }
 
     if (help) {
-        print_help(args[0], os);
+        print_help(name, os);
         return EXIT_SUCCESS;
     }
 
+    if (pipeline && interactive) {
+        err << "syntax error: options '--pipeline' and '--interactive' cannot be combined\n";
+        print_usage(name, err);
+        return EXIT_FAILURE;
+    }
+
+    if (journal && !in_place) {
+        err << "syntax error: option '--journal' requires '--in-place'\n";
+        print_usage(name, err);
+        return EXIT_FAILURE;
+    }
+
+    if (in_place && (batch || pipeline || interactive || paths.size() != 1)) {
+        err << "syntax error: option '--in-place' requires a single <input-file>, and no other mode\n";
+        print_usage(name, err);
+        return EXIT_FAILURE;
+    }
+
+    if (fields && !records) {
+        err << "syntax error: option '--fields' requires '--records'\n";
+        print_usage(name, err);
+        return EXIT_FAILURE;
+    }
+
+    if (records) {
+        if (batch || in_place || pipeline || interactive || serve) {
+            err << "syntax error: option '--records' cannot be combined with any other mode\n";
+            print_usage(name, err);
+            return EXIT_FAILURE;
+        }
+
+        // columns are numbered from 1, as in cut(1)
+        std::vector<absl::string_view> list;
+        if (fields) list = absl::StrSplit(*fields, ',');
+        for (auto field : list) {
+            std::size_t column;
+            if (records->format == core::record_format_e::jsonl) {
+                records->keys.emplace_back(field);
+            }
+            else if (absl::SimpleAtoi(field, &column) && column != 0) {
+                records->columns.push_back(column - 1);
+            }
+            else {
+                err << "syntax error: option '--fields' requires a list of column numbers, from 1\n";
+                print_usage(name, err);
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    if ((edits || apply) && (batch || in_place || pipeline || interactive || serve || records || (edits && apply))) {
+        err << "syntax error: options '--edits' and '--apply' cannot be combined with any other mode\n";
+        print_usage(name, err);
+        return EXIT_FAILURE;
+    }
+
+    if (serve && (batch || in_place || pipeline || interactive || !paths.empty())) {
+        err << "syntax error: option '--serve' cannot be combined with files or any other mode\n";
+        print_usage(name, err);
+        return EXIT_FAILURE;
+    }
+
+    if (batch) {
+        if (pipeline || interactive) {
+            err << "syntax error: option '--batch' cannot be combined with '--pipeline' or '--interactive'\n";
+            print_usage(name, err);
+            return EXIT_FAILURE;
+        }
+        for (auto path : paths) inputs.emplace_back(path);
+        return parsed_args;
+    }
+
+    if (paths.size() > 2) {
+        err << "syntax error: too many arguments provided\n";
+        print_usage(name, err);
+        return EXIT_FAILURE;
+    }
+    if (paths.size() > 0) infile.emplace(paths[0]);
+    if (paths.size() > 1) outfile.emplace(paths[1]);
+
     return parsed_args;
 }
\ No newline at end of file
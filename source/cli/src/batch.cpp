@@ -0,0 +1,210 @@
+#include "batch.h"
+#include "core/digitize.h"
+#include "core/mapped_file.h"
+#include "core/scheduler.h"
+
+#include "absl/strings/string_view.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <set>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define W2D_HAS_DIRENT 1
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <dirent.h>
+#endif
+
+namespace {
+
+    /// A file of the batch.
+    struct batch_file_t {
+        std::string input;      //!< Path to the input file.
+        std::string output;     //!< Path to the output file.
+        std::uint64_t size;     //!< Size of the input file, 0 if unknown.
+    };
+
+    /// Returns the last component of `path`.
+    absl::string_view base_name(absl::string_view path) noexcept
+    {
+        auto pos = path.find_last_of("/\\");
+        return pos == absl::string_view::npos ? path : path.substr(pos + 1);
+    }
+
+    /// Returns `dir` joined with `name`.
+    std::string join_path(absl::string_view dir, absl::string_view name) noexcept
+    {
+        std::string path(dir);
+        if (!path.empty() && path.back() != '/' && path.back() != '\\') path += '/';
+        path.append(name.data(), name.size());
+        return path;
+    }
+
+#if defined(W2D_HAS_DIRENT)
+
+    bool is_directory(const std::string& path) noexcept
+    {
+        struct stat st;
+        return ::stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+    }
+
+    bool make_directory(const std::string& path) noexcept
+    {
+        return ::mkdir(path.c_str(), 0777) == 0 || is_directory(path);
+    }
+
+    std::uint64_t file_size(const std::string& path) noexcept
+    {
+        struct stat st;
+        return ::stat(path.c_str(), &st) == 0 ? static_cast<std::uint64_t>(st.st_size) : 0;
+    }
+
+    bool same_file(const std::string& a, const std::string& b) noexcept
+    {
+        struct stat sa, sb;
+        return ::stat(a.c_str(), &sa) == 0 && ::stat(b.c_str(), &sb) == 0 &&
+               sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino;
+    }
+
+    /// Appends the paths of the regular files of directory `path` to `files`, sorted by name.
+    bool list_directory(const std::string& path, std::vector<std::string>& files) noexcept
+    {
+        DIR* dir = ::opendir(path.c_str());
+        if (!dir) return false;
+
+        std::vector<std::string> names;
+        while (auto entry = ::readdir(dir)) {
+            auto file = join_path(path, entry->d_name);
+            if (core::mapped_file_t::is_regular_file(file)) names.push_back(std::move(file));
+        }
+        ::closedir(dir);
+
+        std::sort(names.begin(), names.end());
+        files.insert(files.end(), names.begin(), names.end());
+        return true;
+    }
+
+#else
+
+    // without system APIs, directories cannot be inspected and the output
+    // directory is assumed to exist
+
+    bool is_directory(const std::string&) noexcept { return false; }
+    bool make_directory(const std::string&) noexcept { return true; }
+    std::uint64_t file_size(const std::string&) noexcept { return 0; }
+    bool same_file(const std::string& a, const std::string& b) noexcept { return a == b; }
+    bool list_directory(const std::string&, std::vector<std::string>&) noexcept { return false; }
+
+#endif
+
+    /// Converts a single file, returns the error message if it could not be converted.
+    std::string convert_file(const batch_file_t& file, bool overwrite, core::stats_t* stats) noexcept
+    {
+        core::mapped_file_t mapped;
+        std::ifstream ifobj;
+        if (core::mapped_file_t::is_regular_file(file.input))
+            mapped.open(file.input);
+        if (!mapped.is_open())
+            ifobj.open(file.input);
+        if (!mapped.is_open() && !ifobj.good())
+            return "could not access '" + file.input + "'";
+
+        // same race condition as with a single output file, see run()
+        if (std::ifstream{ file.output, std::ios::binary }.good()) {
+            if (!overwrite)
+                return "file '" + file.output + "' already exists, use --force to overwrite it";
+            if (same_file(file.input, file.output))
+                return "file '" + file.input + "' cannot be converted into itself";
+        }
+
+        std::ofstream ofobj(file.output);
+        if (!ofobj.good())
+            return "could not access '" + file.output + "'";
+
+        if (mapped.is_open()) core::convert(mapped.view(), ofobj, stats);
+        else                  core::convert(ifobj, ofobj, stats);
+
+        ofobj.close();
+        if (ofobj.fail())
+            return "could not write '" + file.output + "'";
+        return {};
+    }
+}
+
+int run_batch(const args_t& args, std::istream& in, std::ostream& err) noexcept
+{
+    // inputs are either the arguments or a manifest with a path per line
+    std::vector<std::string> inputs = args.inputs;
+    if (inputs.empty()) {
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (!line.empty()) inputs.push_back(std::move(line));
+        }
+    }
+
+    auto& outdir = *args.batch;
+    if (!make_directory(outdir)) {
+        err << "error: could not create directory '" << outdir << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // directories are expanded into their regular files
+    std::vector<std::string> paths;
+    for (auto& input : inputs) {
+        if (!is_directory(input) || !list_directory(input, paths))
+            paths.push_back(input);
+    }
+
+    std::size_t failed = 0;
+    std::vector<batch_file_t> files;
+    std::set<std::string> outputs;
+    for (auto& path : paths) {
+        auto output = join_path(outdir, base_name(path));
+        if (!outputs.insert(output).second) {
+            err << "error: file '" << path << "' would overwrite the conversion of another file in '" << output << "'" << std::endl;
+            ++failed;
+            continue;
+        }
+        files.push_back({ path, std::move(output), file_size(path) });
+    }
+
+    // largest files first, so that the last ones to finish are short
+    std::stable_sort(files.begin(), files.end(), [](const batch_file_t& a, const batch_file_t& b) {
+        return a.size > b.size;
+    });
+
+    auto threads = core::task_threads(files.size(), args.jobs);
+    std::vector<core::stats_t> stats(threads);
+    std::mutex err_mutex;
+    std::atomic<std::size_t> failed_tasks(0);
+
+    core::run_tasks(files.size(), args.jobs, [&](std::size_t task, std::size_t thread) {
+        auto error = convert_file(files[task], args.overwrite, args.stats ? &stats[thread] : nullptr);
+        if (error.empty()) return;
+
+        std::lock_guard<std::mutex> lock(err_mutex);
+        err << "error: " << error << std::endl;
+        ++failed_tasks;
+    });
+    failed += failed_tasks;
+
+    if (args.stats) {
+        for (std::size_t i = 1; i < stats.size(); ++i) stats[0].merge(stats[i]);
+        core::print_stats(stats[0], err);
+    }
+
+    if (failed != 0) {
+        err << "error: " << failed << " of " << paths.size() << " files could not be converted" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
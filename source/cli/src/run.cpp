@@ -1,5 +1,12 @@
 #include "args.h"
+#include "batch.h"
+#include "serve.h"
 #include "core/digitize.h"
+#include "core/edits.h"
+#include "core/grammar.h"
+#include "core/mapped_file.h"
+#include "core/records.h"
+#include "core/rewrite.h"
 
 #include <iostream>
 #include <fstream>
@@ -11,6 +18,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdlib>
+#include <chrono>
 
 int run(int argc, char const* const* argv, std::istream& in, std::ostream& out, std::ostream& err) noexcept
 {
@@ -20,19 +28,50 @@ int run(int argc, char const* const* argv, std::istream& in, std::ostream& out,
         return absl::get<int>(args_variant);
 
     auto& args = absl::get<args_t>(args_variant);
+    core::set_grammar_variant(args.grammar);
+    if (args.batch) return run_batch(args, in, err);
+    if (args.serve) return run_serve(args, err);
+
+    // the output of the conversion in place is the input file itself
+    core::stats_t stats;
+    auto stats_ptr = args.stats ? &stats : nullptr;
+
+    if (args.in_place) {
+        if (!core::rewrite_file(*args.infile, args.journal ? *args.journal : std::string(), stats_ptr)) {
+            err << "error: could not convert '" << *args.infile << "' in place" << std::endl;
+            return EXIT_FAILURE;
+        }
+        if (args.stats) core::print_stats(stats, err);
+        return EXIT_SUCCESS;
+    }
 
     // open files if appropiate
+    core::mapped_file_t mapped;
     std::ifstream ifobj;
+    std::ifstream script;
     std::ofstream ofobj;
 
     if (args.infile) {
-        ifobj.open(*args.infile);
-        if (!ifobj.good()) {
+        // regular files are memory mapped in order to avoid copying them,
+        // fall back to streams if that is not possible
+        if (core::mapped_file_t::is_regular_file(*args.infile))
+            mapped.open(*args.infile);
+        if (!mapped.is_open())
+            ifobj.open(*args.infile);
+        if (!mapped.is_open() && !ifobj.good()) {
             err << "error: could not access '" << *args.infile << "'" << std::endl;
             return EXIT_FAILURE;
         }
     }
 
+    if (args.apply) {
+        script.open(*args.apply, std::ios::binary);
+        if (!script.good()) {
+            err << "error: could not access '" << *args.apply << "'" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
     if (args.outfile) {
         // TODO unfortunately, there is a filesystem race condition here, however, until
         //      C++17 the C11 'x' flag of fopen was not standardized, thus there is
@@ -44,7 +83,7 @@ int run(int argc, char const* const* argv, std::istream& in, std::ostream& out,
             err << "error: file '" << *args.outfile << "' already exists, use --force to overwrite it" << std::endl;
             return EXIT_FAILURE;
         }
-        ofobj.open(*args.outfile);
+        ofobj.open(*args.outfile, args.edits ? std::ios::out | std::ios::binary : std::ios::out);
         if (!ofobj.good()) {
             err << "error: could not access '" << *args.outfile << "'" << std::endl;
             return EXIT_FAILURE;
@@ -52,16 +91,49 @@ int run(int argc, char const* const* argv, std::istream& in, std::ostream& out,
     }
 
     // dispatch appropriately
-    if (ifobj.is_open() && ofobj.is_open()) {
-        core::convert(ifobj, ofobj);
+    if (args.apply) {
+        auto& is = ifobj.is_open() ? static_cast<std::istream&>(ifobj) : in;
+        auto& os = ofobj.is_open() ? static_cast<std::ostream&>(ofobj) : out;
+        bool applied = mapped.is_open() ? core::apply_edits(mapped.view(), script, os) : core::apply_edits(is, script, os);
+        if (!applied) {
+            err << "error: edit script '" << *args.apply << "' is malformed or does not fit the input" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    else if (args.edits) {
+        auto& is = ifobj.is_open() ? static_cast<std::istream&>(ifobj) : in;
+        auto& os = ofobj.is_open() ? static_cast<std::ostream&>(ofobj) : out;
+        if (mapped.is_open()) core::find_edits(mapped.view(), os, *args.edits, args.jobs, core::default_chunk_size, stats_ptr);
+        else                  core::find_edits(is, os, *args.edits, stats_ptr);
     }
-    else if (ifobj.is_open()) {
-        core::convert(ifobj, out);
+    else if (args.records) {
+        // records are split in batches, so streams are read whole
+        std::string text;
+        if (!mapped.is_open()) {
+            auto& is = ifobj.is_open() ? static_cast<std::istream&>(ifobj) : in;
+            text.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+        }
+        auto view = mapped.is_open() ? mapped.view() : absl::string_view(text);
+        auto& os = ofobj.is_open() ? static_cast<std::ostream&>(ofobj) : out;
+        core::convert_records(view, os, *args.records, args.jobs, core::default_chunk_size, stats_ptr);
+    }
+    else if (mapped.is_open() && ofobj.is_open()) {
+        core::convert(mapped.view(), ofobj, args.jobs, core::default_chunk_size, stats_ptr);
+    }
+    else if (mapped.is_open()) {
+        core::convert(mapped.view(), out, args.jobs, core::default_chunk_size, stats_ptr);
     }
     else {
-        assert(!ofobj.is_open());
-        core::convert(in, out);
+        // streams are either converted serially, in a pipeline or with bounded latency
+        auto& is = ifobj.is_open() ? static_cast<std::istream&>(ifobj) : in;
+        auto& os = ofobj.is_open() ? static_cast<std::ostream&>(ofobj) : out;
+        assert(ifobj.is_open() || !ofobj.is_open());
+        if (args.pipeline)         core::convert_pipelined(is, os, args.queue_depth, stats_ptr);
+        else if (args.interactive) core::convert_interactive(is, os, std::chrono::milliseconds(args.max_hold), stats_ptr);
+        else                       core::convert(is, os, stats_ptr);
     }
 
+    if (args.stats) core::print_stats(stats, err);
+
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,441 @@
+#include "serve.h"
+#include "core/digitize.h"
+
+#include "absl/strings/string_view.h"
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define W2D_HAS_SOCKETS 1
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+#if defined(W2D_HAS_SOCKETS)
+
+namespace {
+
+    /// Size of the header of a frame, its kind and the size of its payload.
+    constexpr std::size_t frame_header_size = 5;
+
+    bool read_all(int fd, char* data, std::size_t size) noexcept
+    {
+        while (size != 0) {
+            auto n = ::read(fd, data, size);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            data += n;
+            size -= static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    bool write_all(int fd, const char* data, std::size_t size) noexcept
+    {
+        while (size != 0) {
+            auto n = ::write(fd, data, size);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            data += n;
+            size -= static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    /**
+     * Histogram of latencies, in buckets of powers of two microseconds.
+     *
+     * Buckets are atomic, so that every worker adds to the same histogram
+     * while a stats request reads it.
+     */
+    class latency_histogram_t {
+    public:
+        /// Number of buckets, the last one counts every latency above 2^(bucket_count-2) us.
+        static constexpr std::size_t bucket_count = 32;
+
+        latency_histogram_t() noexcept : requests_(0), bytes_in_(0), bytes_out_(0)
+        {
+            for (auto& bucket : buckets_) bucket = 0;
+        }
+
+        /// Adds a conversion of `in` characters into `out` characters that took `latency`.
+        void add(std::chrono::steady_clock::duration latency, std::size_t in, std::size_t out) noexcept
+        {
+            auto us = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+            std::size_t bucket = 0;
+            while (bucket + 1 < bucket_count && (std::int64_t(1) << bucket) < us) ++bucket;
+
+            buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+            requests_.fetch_add(1, std::memory_order_relaxed);
+            bytes_in_.fetch_add(in, std::memory_order_relaxed);
+            bytes_out_.fetch_add(out, std::memory_order_relaxed);
+        }
+
+        /// Prints the counters and the non-empty range of buckets, along with some percentiles.
+        void print(std::ostream& os) const noexcept
+        {
+            std::uint64_t counts[bucket_count];
+            std::uint64_t total = 0;
+            for (std::size_t i = 0; i != bucket_count; ++i) total += counts[i] = buckets_[i].load(std::memory_order_relaxed);
+
+            os << "requests: " << requests_.load(std::memory_order_relaxed) << "\n";
+            os << "bytes: " << bytes_in_.load(std::memory_order_relaxed) << " in, "
+               << bytes_out_.load(std::memory_order_relaxed) << " out\n";
+            if (total == 0) return;
+
+            // percentiles are the upper bounds of the buckets where they fall
+            const double percentiles[] = { 0.5, 0.9, 0.99, 0.999 };
+            os << "latency percentiles (us):";
+            for (auto p : percentiles) {
+                std::uint64_t seen = 0;
+                std::size_t i = 0;
+                while (seen + counts[i] < p * total) seen += counts[i++];
+                os << " p" << p * 100 << " <= " << upper_bound(i);
+            }
+            os << "\n";
+
+            std::size_t first = 0, last = bucket_count;
+            while (counts[first] == 0) ++first;
+            while (counts[last - 1] == 0) --last;
+            os << "latency histogram (us):\n";
+            for (auto i = first; i != last; ++i) {
+                if (i + 1 == bucket_count) os << "  >  " << upper_bound(i - 1);
+                else                       os << "  <= " << upper_bound(i);
+                os << ": " << counts[i] << "\n";
+            }
+        }
+
+    private:
+        static std::int64_t upper_bound(std::size_t bucket) noexcept { return std::int64_t(1) << bucket; }
+
+        std::atomic<std::uint64_t> buckets_[bucket_count];  //!< Number of conversions in each bucket.
+        std::atomic<std::uint64_t> requests_;               //!< Number of conversions.
+        std::atomic<std::uint64_t> bytes_in_;               //!< Number of characters converted.
+        std::atomic<std::uint64_t> bytes_out_;              //!< Number of characters of the responses.
+    };
+
+    constexpr std::size_t latency_histogram_t::bucket_count;
+
+    /// State shared by the thread that polls the connections and the workers.
+    struct server_t {
+        int wake[2];                        //!< Pipe that wakes up the polling thread.
+        std::mutex mutex;                   //!< Guards the members below.
+        std::condition_variable ready;      //!< Signaled when a connection is pending or the server stops.
+        std::deque<int> pending;            //!< Connections with a request to be served.
+        std::vector<int> returned;          //!< Connections served, to be polled again.
+        bool stopping;                      //!< Whether the server is stopping.
+        latency_histogram_t latency;        //!< Latency of the conversions.
+    };
+
+    /// Write end of the wake pipe of the running server, for the signal handlers.
+    volatile sig_atomic_t signal_wake_fd = -1;
+
+    /// Whether a signal or a shutdown request asked the running server to stop,
+    /// lock-free so that the signal handlers can set it.
+    std::atomic<bool> stop_requested(false);
+
+    extern "C" void on_stop_signal(int)
+    {
+        // only async-signal-safe calls
+        stop_requested = true;
+        char byte = 0;
+        if (signal_wake_fd >= 0) (void) !::write(signal_wake_fd, &byte, 1);
+    }
+
+    /// Wakes up the polling thread, never blocks: with the pipe full the thread
+    /// is awake already, and it takes the returned connections all at once.
+    void wake_up(server_t& server) noexcept
+    {
+        char byte = 0;
+        (void) !::write(server.wake[1], &byte, 1);
+    }
+
+    void set_cloexec(int fd) noexcept
+    {
+        ::fcntl(fd, F_SETFD, ::fcntl(fd, F_GETFD) | FD_CLOEXEC);
+    }
+
+    void set_nonblock(int fd) noexcept
+    {
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+
+    void stop(server_t& server) noexcept
+    {
+        std::lock_guard<std::mutex> lock(server.mutex);
+        server.stopping = true;
+        server.ready.notify_all();
+    }
+
+    /// Serves a single request of connection `fd`, returns false if the connection must be closed.
+    bool serve_request(int fd, server_t& server, core::converter_t& converter, std::string& request, std::string& response, core::stats_t* stats) noexcept
+    {
+        serve_frame_e kind;
+        if (!read_frame(fd, kind, request)) return false;
+
+        auto start = std::chrono::steady_clock::now();
+        switch (kind) {
+        case serve_frame_e::convert: {
+            // a large request may not fit in memory, which only fails that request
+            try {
+                if (stats) converter.convert(request, response, *stats);
+                else       converter.convert(request, response);
+            }
+            catch (const std::bad_alloc&) {
+                response.clear();
+                response.shrink_to_fit();
+                return write_frame(fd, serve_frame_e::error, "out of memory");
+            }
+
+            // counted before responding, so that a client sees its own requests in the stats
+            server.latency.add(std::chrono::steady_clock::now() - start, request.size(), response.size());
+            return write_frame(fd, serve_frame_e::ok, response);
+        }
+        case serve_frame_e::stats: {
+            std::ostringstream os;
+            server.latency.print(os);
+            return write_frame(fd, serve_frame_e::ok, os.str());
+        }
+        case serve_frame_e::shutdown:
+            stop_requested = true;
+            wake_up(server);
+            return write_frame(fd, serve_frame_e::ok, {});
+        default:
+            return write_frame(fd, serve_frame_e::error, "unknown request");
+        }
+    }
+
+    /// Serves the pending connections until the server stops and none is pending.
+    void run_worker(server_t& server, core::stats_t* stats) noexcept
+    {
+        core::converter_t converter;
+        std::string request, response;
+        for (;;) {
+            int fd;
+            {
+                std::unique_lock<std::mutex> lock(server.mutex);
+                server.ready.wait(lock, [&server]() { return server.stopping || !server.pending.empty(); });
+                if (server.pending.empty()) return;
+                fd = server.pending.front();
+                server.pending.pop_front();
+            }
+
+            if (!serve_request(fd, server, converter, request, response, stats)) {
+                ::close(fd);
+                continue;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(server.mutex);
+                server.returned.push_back(fd);
+            }
+            wake_up(server);
+        }
+    }
+
+    /// Waits for connections and requests, and hands them to the workers, until a stop is requested.
+    void poll_connections(int listener, server_t& server, std::vector<int>& idle) noexcept
+    {
+        std::vector<pollfd> fds;
+        for (;;) {
+            fds.clear();
+            fds.push_back({ listener, POLLIN, 0 });
+            fds.push_back({ server.wake[0], POLLIN, 0 });
+            for (auto fd : idle) fds.push_back({ fd, POLLIN, 0 });
+
+            if (::poll(fds.data(), static_cast<nfds_t>(fds.size()), -1) < 0) {
+                if (errno == EINTR) continue;
+                return;
+            }
+
+            // connections that are readable, or closed, are handed to the workers
+            idle.clear();
+            for (std::size_t i = 2; i < fds.size(); ++i) {
+                if (fds[i].revents == 0) {
+                    idle.push_back(fds[i].fd);
+                    continue;
+                }
+                std::lock_guard<std::mutex> lock(server.mutex);
+                server.pending.push_back(fds[i].fd);
+                server.ready.notify_one();
+            }
+
+            if (fds[0].revents & POLLIN) {
+                int fd = ::accept(listener, nullptr, nullptr);
+                if (fd >= 0) {
+                    set_cloexec(fd);
+                    timeval timeout = { serve_timeout, 0 };
+                    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+                    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+                    idle.push_back(fd);
+                }
+            }
+
+            if (fds[1].revents & POLLIN) {
+                // drained until empty, the pipe is non-blocking
+                char bytes[64];
+                while (::read(server.wake[0], bytes, sizeof(bytes)) > 0) {}
+                if (stop_requested) return;
+
+                std::lock_guard<std::mutex> lock(server.mutex);
+                idle.insert(idle.end(), server.returned.begin(), server.returned.end());
+                server.returned.clear();
+            }
+        }
+    }
+
+    /// Creates a socket listening at `path`, replacing a stale socket, returns -1 on errors.
+    int listen_at(const std::string& path, std::ostream& err) noexcept
+    {
+        sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+            err << "error: invalid socket path '" << path << "'" << std::endl;
+            return -1;
+        }
+        std::memcpy(addr.sun_path, path.data(), path.size());
+
+        // a socket left by a server that did not stop cleanly is replaced,
+        // but any other kind of file is kept
+        struct stat st;
+        if (::lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) ::unlink(path.c_str());
+
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            err << "error: could not create a socket" << std::endl;
+            return -1;
+        }
+        set_cloexec(fd);
+        if (::bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd, SOMAXCONN) != 0) {
+            err << "error: could not listen at '" << path << "': " << std::strerror(errno) << std::endl;
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+}
+
+bool write_frame(int fd, serve_frame_e kind, absl::string_view payload) noexcept
+{
+    if (payload.size() > serve_max_payload) return false;
+
+    auto size = static_cast<std::uint32_t>(payload.size());
+    char header[frame_header_size] = {
+        static_cast<char>(kind),
+        static_cast<char>(size >> 24), static_cast<char>(size >> 16), static_cast<char>(size >> 8), static_cast<char>(size)
+    };
+    return write_all(fd, header, sizeof(header)) && write_all(fd, payload.data(), payload.size());
+}
+
+bool read_frame(int fd, serve_frame_e& kind, std::string& payload) noexcept
+{
+    unsigned char header[frame_header_size];
+    if (!read_all(fd, reinterpret_cast<char*>(header), sizeof(header))) return false;
+
+    kind = static_cast<serve_frame_e>(header[0]);
+    auto size = std::size_t(header[1]) << 24 | std::size_t(header[2]) << 16 | std::size_t(header[3]) << 8 | std::size_t(header[4]);
+    if (size > serve_max_payload) return false;
+
+    // a payload that does not fit in memory is left unread, so the connection is lost
+    try { payload.resize(size); }
+    catch (const std::bad_alloc&) { return false; }
+    return size == 0 || read_all(fd, &payload[0], size);
+}
+
+int run_serve(const args_t& args, std::ostream& err) noexcept
+{
+    auto& path = *args.serve;
+    int listener = listen_at(path, err);
+    if (listener < 0) return EXIT_FAILURE;
+
+    server_t server;
+    server.stopping = false;
+    if (::pipe(server.wake) != 0) {
+        err << "error: could not create a pipe" << std::endl;
+        ::close(listener);
+        ::unlink(path.c_str());
+        return EXIT_FAILURE;
+    }
+    set_cloexec(server.wake[0]);
+    set_cloexec(server.wake[1]);
+    // neither the workers nor the signal handlers must block on a full pipe
+    set_nonblock(server.wake[0]);
+    set_nonblock(server.wake[1]);
+
+    // writing to a client that left must not kill the server, and stop signals
+    // stop it cleanly
+    stop_requested = false;
+    signal_wake_fd = server.wake[1];
+    auto old_pipe = ::signal(SIGPIPE, SIG_IGN);
+    auto old_int = ::signal(SIGINT, on_stop_signal);
+    auto old_term = ::signal(SIGTERM, on_stop_signal);
+
+    auto jobs = args.jobs != 0 ? args.jobs : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<core::stats_t> stats(jobs);
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i != jobs; ++i)
+        workers.emplace_back(run_worker, std::ref(server), args.stats ? &stats[i] : nullptr);
+
+    std::vector<int> idle;
+    poll_connections(listener, server, idle);
+
+    // no new connections are accepted, but the pending ones are served
+    ::close(listener);
+    ::unlink(path.c_str());
+    stop(server);
+    for (auto& worker : workers) worker.join();
+
+    ::signal(SIGPIPE, old_pipe);
+    ::signal(SIGINT, old_int);
+    ::signal(SIGTERM, old_term);
+    signal_wake_fd = -1;
+
+    for (auto fd : idle) ::close(fd);
+    for (auto fd : server.returned) ::close(fd);
+    ::close(server.wake[0]);
+    ::close(server.wake[1]);
+
+    if (args.stats) {
+        for (std::size_t i = 1; i < stats.size(); ++i) stats[0].merge(stats[i]);
+        core::print_stats(stats[0], err);
+        server.latency.print(err);
+    }
+    return EXIT_SUCCESS;
+}
+
+#else
+
+// without system APIs there are no Unix domain sockets
+
+bool write_frame(int, serve_frame_e, absl::string_view) noexcept { return false; }
+bool read_frame(int, serve_frame_e&, std::string&) noexcept { return false; }
+
+int run_serve(const args_t&, std::ostream& err) noexcept
+{
+    err << "error: option '--serve' is not supported on this platform" << std::endl;
+    return EXIT_FAILURE;
+}
+
+#endif
@@ -1,12 +1,24 @@
 #include "unittest.h"
 
 #include "run.h"
+#include "serve.h"
+#include "core/digitize.h"
+#include "core/grammar.h"
 
 #include <sstream>
 #include <fstream>
 #include <cstdio>
 #include <array>
 #include <cstdlib>
+#include <thread>
+#include <chrono>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
 
 struct test_run : ::testing::Test {};
 
@@ -120,6 +132,56 @@ TEST(test_run, conformance)
         ASSERT_EQ(out.str(), "random token 42");
     }
 
+    // read from file with several jobs
+    {
+        std::stringstream out, err;
+        auto arr = std::array<const char*, 4>{ "exe", "--jobs", "3", fname };
+        auto code = run((int) arr.size(), arr.data(), in, out, err);
+        ASSERT_EQ(code, EXIT_SUCCESS);
+        ASSERT_TRUE(err.str().empty());
+        ASSERT_EQ(out.str(), "random token 42");
+    }
+
+    // read from stdin in a pipeline
+    {
+        std::stringstream pin("forty-two dogs"), out, err;
+        auto arr = std::array<const char*, 4>{ "exe", "-p", "--queue-depth", "2" };
+        auto code = run((int) arr.size(), arr.data(), pin, out, err);
+        ASSERT_EQ(code, EXIT_SUCCESS);
+        ASSERT_TRUE(err.str().empty());
+        ASSERT_EQ(out.str(), "42 dogs");
+    }
+
+    // read from stdin with bounded latency
+    {
+        std::stringstream pin("forty-two dogs\nand one"), out, err;
+        auto arr = std::array<const char*, 4>{ "exe", "-i", "--max-hold", "10" };
+        auto code = run((int) arr.size(), arr.data(), pin, out, err);
+        ASSERT_EQ(code, EXIT_SUCCESS);
+        ASSERT_TRUE(err.str().empty());
+        ASSERT_EQ(out.str(), "42 dogs\nand 1");
+    }
+
+    // trigger incompatible modes
+    {
+        std::stringstream out, err;
+        auto arr = std::array<const char*, 3>{ "exe", "-i", "-p" };
+        auto code = run((int) arr.size(), arr.data(), in, out, err);
+        ASSERT_EQ(code, EXIT_FAILURE);
+        ASSERT_FALSE(err.str().empty());
+        ASSERT_TRUE(out.str().empty());
+    }
+
+    // trigger invalid number of jobs
+    {
+        std::stringstream out, err;
+        auto arr = std::array<const char*, 3>{ "exe", fname, "-j" };
+        auto code = run((int) arr.size(), arr.data(), in, out, err);
+        ASSERT_EQ(code, EXIT_FAILURE);
+        ASSERT_FALSE(err.str().empty());
+        ASSERT_TRUE(out.str().empty());
+    }
+
     // fail to overwrite file
     std::ofstream fobj_out{ fname_out };
     ASSERT_TRUE(fobj_out.is_open());
@@ -157,3 +219,364 @@ TEST(test_run, conformance)
     std::remove(fname);
     std::remove(fname_out);
 }
+
+TEST(test_run, batch)
+{
+    const char* inputs[] = { "test_kQ3vTmx8Ra.a", "test_kQ3vTmx8Ra.b" };
+    auto dir = "test_kQ3vTmx8Ra.dir";
+    auto dir2 = "test_kQ3vTmx8Ra.dir2";
+    auto missing = "test_kQ3vTmx8Ra.missing";
+
+    auto output = [](const std::string& dir, const std::string& name) {
+        std::stringstream contents;
+        std::ifstream file{ dir + "/" + name };
+        contents << file.rdbuf();
+        return contents.str();
+    };
+    auto clean = [&]() {
+        for (auto input : inputs) {
+            std::remove(input);
+            std::remove((std::string(dir) + "/" + input).c_str());
+            std::remove((std::string(dir2) + "/" + input).c_str());
+        }
+        std::remove(dir);
+        std::remove(dir2);
+    };
+
+    clean();
+    std::ofstream{ inputs[0] } << "forty-two dogs";
+    std::ofstream{ inputs[1] } << "one hundred and one cats";
+
+    // a missing file is reported, but the rest of the batch is converted
+    {
+        std::stringstream in, out, err;
+        auto arr = std::array<const char*, 7>{ "exe", "--batch", dir, "-j", "2", inputs[0], missing };
+        auto code = run((int) arr.size(), arr.data(), in, out, err);
+        ASSERT_EQ(code, EXIT_FAILURE);
+        ASSERT_NE(err.str().find(missing), std::string::npos);
+        ASSERT_TRUE(out.str().empty());
+        ASSERT_EQ(output(dir, inputs[0]), "42 dogs");
+    }
+
+    // paths are read from stdin, and existing files are only replaced with --force
+    {
+        std::stringstream in(std::string(inputs[0]) + "\n" + inputs[1] + "\n"), out, err;
+        auto arr = std::array<const char*, 3>{ "exe", "-b", dir };
+        auto code = run((int) arr.size(), arr.data(), in, out, err);
+        ASSERT_EQ(code, EXIT_FAILURE);
+        ASSERT_EQ(output(dir, inputs[1]), "101 cats");
+    }
+    {
+        std::stringstream in(std::string(inputs[0]) + "\r\n\n" + inputs[1]), out, err;
+        auto arr = std::array<const char*, 4>{ "exe", "-b", dir, "-f" };
+        auto code = run((int) arr.size(), arr.data(), in, out, err);
+        ASSERT_EQ(code, EXIT_SUCCESS);
+        ASSERT_TRUE(err.str().empty());
+    }
+
+    // directories are expanded into their files
+    {
+        std::stringstream in, out, err;
+        auto arr = std::array<const char*, 6>{ "exe", "-b", dir2, "--jobs", "0", dir };
+        auto code = run((int) arr.size(), arr.data(), in, out, err);
+        ASSERT_EQ(code, EXIT_SUCCESS);
+        ASSERT_TRUE(err.str().empty());
+        ASSERT_EQ(output(dir2, inputs[0]), "42 dogs");
+        ASSERT_EQ(output(dir2, inputs[1]), "101 cats");
+    }
+
+    // files with the same name would overwrite each other
+    {
+        std::stringstream in, out, err;
+        auto path = std::string(dir) + "/" + inputs[0];
+        auto arr = std::array<const char*, 6>{ "exe", "-b", dir2, "-f", inputs[0], path.c_str() };
+        auto code = run((int) arr.size(), arr.data(), in, out, err);
+        ASSERT_EQ(code, EXIT_FAILURE);
+        ASSERT_FALSE(err.str().empty());
+    }
+
+    // batch mode cannot be combined with streaming modes
+    {
+        std::stringstream in, out, err;
+        auto arr = std::array<const char*, 4>{ "exe", "-b", dir, "-p" };
+        auto code = run((int) arr.size(), arr.data(), in, out, err);
+        ASSERT_EQ(code, EXIT_FAILURE);
+        ASSERT_FALSE(err.str().empty());
+    }
+
+    clean();
+}
+
+TEST(test_run, in_place)
+{
+    auto fname = "test_Hn7cVq1sYb";
+    auto journal = "test_Hn7cVq1sYb.journal";
+    std::remove(fname);
+    std::remove(journal);
+    std::ofstream{ fname } << "forty-two dogs and a million cats";
+
+    // the file is converted over itself
+    {
+        std::stringstream in, out, err;
+        auto arr = std::array<const char*, 5>{ "exe", "--in-place", "--journal", journal, fname };
+        auto code = run((int) arr.size(), arr.data(), in, out, err);
+        ASSERT_EQ(code, EXIT_SUCCESS);
+        ASSERT_TRUE(err.str().empty());
+        ASSERT_TRUE(out.str().empty());
+
+        std::stringstream contents;
+        contents << std::ifstream{ fname }.rdbuf();
+        ASSERT_EQ(contents.str(), "42 dogs and 1000000 cats");
+        ASSERT_FALSE(std::ifstream{ journal }.is_open());
+    }
+
+    // an output file, or a journal without in place conversion, are errors
+    {
+        std::stringstream in, out, err;
+        auto arr = std::array<const char*, 4>{ "exe", "--in-place", fname, "other" };
+        auto code = run((int) arr.size(), arr.data(), in, out, err);
+        ASSERT_EQ(code, EXIT_FAILURE);
+        ASSERT_FALSE(err.str().empty());
+    }
+    {
+        std::stringstream in, out, err;
+        auto arr = std::array<const char*, 4>{ "exe", "--journal", journal, fname };
+        auto code = run((int) arr.size(), arr.data(), in, out, err);
+        ASSERT_EQ(code, EXIT_FAILURE);
+        ASSERT_FALSE(err.str().empty());
+    }
+
+    std::remove(fname);
+}
+
+TEST(test_run, records)
+{
+    // only the selected columns are converted, from a stream and from a file
+    {
+        std::stringstream in, out, err;
+        in << "id,text,note\n1,\"one, two\",three\nfour,five,six\n";
+        auto arr = std::array<const char*, 7>{ "exe", "--records", "csv", "--fields", "2", "-j", "2" };
+        auto code = run((int) arr.size(), arr.data(), in, out, err);
+        ASSERT_EQ(code, EXIT_SUCCESS);
+        ASSERT_TRUE(err.str().empty());
+        ASSERT_EQ(out.str(), "id,text,note\n1,\"1, 2\",three\nfour,5,six\n");
+    }
+    {
+        auto fname = "test_Qe4mLz8TwA";
+        std::remove(fname);
+        std::ofstream{ fname } << "{\"n\": \"twelve\", \"t\": \"twelve\"}\n";
+
+        std::stringstream in, out, err;
+        auto arr = std::array<const char*, 6>{ "exe", "--records", "jsonl", "--fields", "t", fname };
+        auto code = run((int) arr.size(), arr.data(), in, out, err);
+        ASSERT_EQ(code, EXIT_SUCCESS);
+        ASSERT_TRUE(err.str().empty());
+        ASSERT_EQ(out.str(), "{\"n\": \"twelve\", \"t\": \"12\"}\n");
+        std::remove(fname);
+    }
+
+    // fields need records, columns start by 1, and records are a mode on their own
+    for (auto arr : { std::array<const char*, 4>{ "exe", "--fields", "1", "--pipeline" },
+                      std::array<const char*, 4>{ "exe", "--records", "tsv", "--fields" },
+                      std::array<const char*, 4>{ "exe", "--records", "tsv", "--pipeline" } }) {
+        std::stringstream in, out, err;
+        auto code = run((int) arr.size(), arr.data(), in, out, err);
+        ASSERT_EQ(code, EXIT_FAILURE);
+        ASSERT_FALSE(err.str().empty());
+    }
+    {
+        std::stringstream in, out, err;
+        auto arr = std::array<const char*, 5>{ "exe", "--records", "tsv", "--fields", "0" };
+        auto code = run((int) arr.size(), arr.data(), in, out, err);
+        ASSERT_EQ(code, EXIT_FAILURE);
+        ASSERT_FALSE(err.str().empty());
+    }
+}
+
+TEST(test_run, edits)
+{
+    auto fname = "test_Vb3nXk7PqE";
+    auto script = "test_Vb3nXk7PqE.edits";
+    std::remove(fname);
+    std::remove(script);
+    std::ofstream{ fname } << "forty-two dogs and a million cats";
+
+    for (auto format : { "binary", "jsonl" }) {
+        // the edit script of the file is written, and applying it converts the file
+        {
+            std::stringstream in, out, err;
+            auto arr = std::array<const char*, 7>{ "exe", "--edits", format, "-j", "2", fname, script };
+            auto code = run((int) arr.size(), arr.data(), in, out, err);
+            ASSERT_EQ(code, EXIT_SUCCESS);
+            ASSERT_TRUE(err.str().empty());
+            ASSERT_TRUE(out.str().empty());
+        }
+        {
+            std::stringstream in, out, err;
+            auto arr = std::array<const char*, 4>{ "exe", "--apply", script, fname };
+            auto code = run((int) arr.size(), arr.data(), in, out, err);
+            ASSERT_EQ(code, EXIT_SUCCESS);
+            ASSERT_TRUE(err.str().empty());
+            ASSERT_EQ(out.str(), "42 dogs and 1000000 cats");
+        }
+        std::remove(script);
+    }
+
+    // from streams too
+    {
+        std::stringstream in, out, err;
+        in << "twelve";
+        auto arr = std::array<const char*, 3>{ "exe", "--edits", "jsonl" };
+        auto code = run((int) arr.size(), arr.data(), in, out, err);
+        ASSERT_EQ(code, EXIT_SUCCESS);
+        ASSERT_EQ(out.str(), "{\"offset\":0,\"length\":6,\"value\":12}\n");
+    }
+
+    // a script that does not fit the input, or modes that cannot be combined
+    {
+        std::ofstream{ script } << "{\"offset\":100,\"length\":1,\"value\":1}\n";
+        std::stringstream in, out, err;
+        auto arr = std::array<const char*, 4>{ "exe", "--apply", script, fname };
+        auto code = run((int) arr.size(), arr.data(), in, out, err);
+        ASSERT_EQ(code, EXIT_FAILURE);
+        ASSERT_FALSE(err.str().empty());
+    }
+    {
+        std::stringstream in, out, err;
+        auto arr = std::array<const char*, 5>{ "exe", "--edits", "jsonl", "--apply", script };
+        auto code = run((int) arr.size(), arr.data(), in, out, err);
+        ASSERT_EQ(code, EXIT_FAILURE);
+        ASSERT_FALSE(err.str().empty());
+    }
+
+    std::remove(fname);
+    std::remove(script);
+}
+
+TEST(test_run, grammar)
+{
+    auto convert = [](const char* variant) {
+        std::stringstream in, out, err;
+        in << "one hundred five and a hundred";
+        auto arr = std::array<const char*, 3>{ "exe", "--grammar", variant };
+        auto code = run((int) arr.size(), arr.data(), in, out, err);
+        return code == EXIT_SUCCESS ? out.str() : "<error>";
+    };
+
+    ASSERT_EQ(convert("british"), "100 5 and 100");
+    ASSERT_EQ(convert("american"), "105 and 100");
+    ASSERT_EQ(convert("no_article"), "100 5 and a hundred");
+    ASSERT_EQ(convert("klingon"), "<error>");
+
+    // the variant is selected by each run, and defaults to the one chosen at build time
+    {
+        std::stringstream in, out, err;
+        in << "one hundred five";
+        auto arr = std::array<const char*, 1>{ "exe" };
+        auto code = run((int) arr.size(), arr.data(), in, out, err);
+        ASSERT_EQ(code, EXIT_SUCCESS);
+        ASSERT_EQ(core::grammar_variant(), core::default_grammar_variant);
+    }
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+
+namespace {
+    /// Client of the serve protocol, standing in for the callers of a server.
+    struct serve_client_t {
+        int fd;
+
+        explicit serve_client_t(const std::string& path) : fd(::socket(AF_UNIX, SOCK_STREAM, 0))
+        {
+            sockaddr_un addr = {};
+            addr.sun_family = AF_UNIX;
+            path.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+
+            // the server may still be starting
+            for (int i = 0; i < 500; ++i) {
+                if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0) return;
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            ::close(fd);
+            fd = -1;
+        }
+
+        ~serve_client_t() { if (fd >= 0) ::close(fd); }
+
+        /// Sends a request, returns the payload of the response or "<error>".
+        std::string request(serve_frame_e kind, const std::string& payload)
+        {
+            serve_frame_e response;
+            std::string result;
+            if (!write_frame(fd, kind, payload) || !read_frame(fd, response, result) || response != serve_frame_e::ok)
+                return "<error>";
+            return result;
+        }
+    };
+}
+
+TEST(test_run, serve)
+{
+    auto socket = "test_Zp4cW8rNue.sock";
+
+    std::stringstream in, out, err;
+    int code = -1;
+    std::thread server([&]() {
+        auto arr = std::array<const char*, 5>{ "exe", "--serve", socket, "-j", "3" };
+        code = run((int) arr.size(), arr.data(), in, out, err);
+    });
+
+    // many clients, each with many requests on the same connection
+    std::string text;
+    for (int i = 0; i < 100; ++i) text += "There are one hundred and twenty-three dogs, a thousand cats.\n";
+    std::ostringstream expected;
+    core::convert(text, expected);
+
+    std::vector<std::string> results(8);
+    std::vector<std::thread> clients;
+    for (auto& result : results) {
+        clients.emplace_back([&]() {
+            serve_client_t client(socket);
+            for (int i = 0; i < 20; ++i) {
+                result = client.request(serve_frame_e::convert, text);
+                if (result != expected.str()) return;
+            }
+            result = client.request(serve_frame_e::convert, "forty-two") == "42" ? expected.str() : "<error>";
+        });
+    }
+    for (auto& client : clients) client.join();
+    for (auto& result : results) ASSERT_EQ(result, expected.str());
+
+    {
+        serve_client_t client(socket);
+        ASSERT_EQ(client.request(serve_frame_e::convert, ""), "");
+
+        // unknown requests are answered with an error, but the connection is kept
+        serve_frame_e kind;
+        std::string payload;
+        ASSERT_TRUE(write_frame(client.fd, static_cast<serve_frame_e>('x'), "one"));
+        ASSERT_TRUE(read_frame(client.fd, kind, payload));
+        ASSERT_EQ(kind, serve_frame_e::error);
+
+        auto stats = client.request(serve_frame_e::stats, "");
+        ASSERT_NE(stats.find("requests: 169\n"), std::string::npos) << stats;
+        ASSERT_NE(stats.find("latency histogram"), std::string::npos);
+
+        ASSERT_EQ(client.request(serve_frame_e::shutdown, ""), "");
+    }
+
+    server.join();
+    ASSERT_EQ(code, EXIT_SUCCESS);
+    ASSERT_TRUE(err.str().empty());
+    ASSERT_TRUE(out.str().empty());
+    ASSERT_NE(::access(socket, F_OK), 0);
+
+    // the server cannot be combined with any other mode
+    {
+        std::stringstream in, out, err;
+        auto arr = std::array<const char*, 4>{ "exe", "--serve", socket, "file" };
+        ASSERT_EQ(run((int) arr.size(), arr.data(), in, out, err), EXIT_FAILURE);
+    }
+}
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef INCLUDE_GUARD__ARENA_H__GUID_f32e39e2c9d34607b95f4dbb99786804
+#define INCLUDE_GUARD__ARENA_H__GUID_f32e39e2c9d34607b95f4dbb99786804
+
+#include "absl/strings/string_view.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace core {
+
+    /**
+     * @brief Bump allocator of text.
+     *
+     * Texts are copied one after the other into large blocks, and they are all
+     * released at once by reset(). The blocks are kept, so an arena that is reset
+     * regularly stops allocating once its blocks can hold the texts stored between
+     * two resets.
+     *
+     * @note Texts never move while stored, so views of them remain valid until
+     *   the arena is reset or destroyed.
+     */
+    class arena_t {
+    public:
+        /// Default size of a block, in characters.
+        static constexpr std::size_t default_block_size = 64 * 1024;
+
+        /// Constructs an empty arena, that allocates blocks of at least `block_size` characters.
+        explicit arena_t(std::size_t block_size = default_block_size) noexcept;
+
+        arena_t(const arena_t&) = delete;
+        arena_t& operator=(const arena_t&) = delete;
+
+        /// Copies `text` into the arena, returns the view of the copy.
+        absl::string_view store(absl::string_view text) noexcept;
+
+        /**
+         * @brief Appends `text` to the last stored text, returns the view of the result.
+         *
+         * The last text is extended in place if there is room after it, otherwise it
+         * is moved to a larger block along with `text`.
+         *
+         * @param last View returned by the last call to store() or append().
+         * @param text Text to append.
+         */
+        absl::string_view append(absl::string_view last, absl::string_view text) noexcept;
+
+        /// Releases all the texts, keeping the blocks for later texts.
+        void reset() noexcept;
+
+        /// Returns the total size of the blocks.
+        std::size_t capacity() const noexcept;
+
+    private:
+        /// Block of texts.
+        struct block_t {
+            std::unique_ptr<char[]> data;   //!< Storage of the block.
+            std::size_t size;               //!< Size of the storage.
+        };
+
+        /// Returns room for `size` characters, moving to the next block that can hold them.
+        char* allocate(std::size_t size) noexcept;
+
+        std::size_t block_size_;        //!< Minimum size of a new block.
+        std::vector<block_t> blocks_;   //!< Blocks, those up to current_ may hold texts.
+        std::size_t current_;           //!< Block where texts are stored.
+        std::size_t used_;              //!< Number of characters used of the current block.
+    };
+
+}
+
+#endif // INCLUDE_GUARD__ARENA_H__GUID_f32e39e2c9d34607b95f4dbb99786804
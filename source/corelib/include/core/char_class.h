@@ -0,0 +1,183 @@
+#ifndef INCLUDE_GUARD__CHAR_CLASS_H__GUID_d0b5a7e24c8f4f6f9a3e1b72c64d8e15
+#define INCLUDE_GUARD__CHAR_CLASS_H__GUID_d0b5a7e24c8f4f6f9a3e1b72c64d8e15
+
+#include <cstdint>
+#include <cstddef>
+
+namespace core {
+
+    /**
+     * @brief The type of a token.
+     */
+    enum class token_category_e : std::uint8_t {
+        space,      //!< Token is formed by whitespace characters.
+        alpha,      //!< Token is formed by letters.
+        other,      //!< Token is punctuation, control characters, etc.
+        end         //!< Sentinel token
+    };
+
+    /**
+     * @brief Instruction sets for which a character classification kernel exists.
+     *
+     * The best supported kernel is selected at runtime (see char_class_isa()).
+     */
+    enum class char_class_isa_e {
+        scalar,     //!< Portable kernel, one character at a time.
+        sse2,       //!< x86 SSE2 kernel, 16 characters at a time.
+        avx2,       //!< x86 AVX2 kernel, 32 characters at a time.
+        avx512      //!< x86 AVX-512BW kernel, 64 characters at a time.
+    };
+
+    /// Number of characters classified at once by classify_block().
+    constexpr std::size_t char_class_block = 64;
+
+    /**
+     * @brief Categories of a block of char_class_block bytes.
+     *
+     * Bit `i` of each mask represents the `i`-th byte of the block. Bytes that are
+     * neither space nor alpha are of the other category. The bytes of multi-byte
+     * UTF-8 characters are only flagged as non-ASCII, as their category depends on
+     * the whole character (see token_scanner_t).
+     */
+    struct char_class_masks_t {
+        std::uint64_t space;        //!< Mask of the ASCII space characters.
+        std::uint64_t alpha;        //!< Mask of the ASCII alpha characters.
+        std::uint64_t non_ascii;    //!< Mask of the bytes that are not ASCII.
+    };
+
+    /**
+     * @brief Returns the category of a single byte.
+     *
+     * Space characters are ' ', '\\t', '\\n', '\\v', '\\f' and '\\r', alpha characters
+     * are the ASCII letters and the rest are other, including any byte that is not
+     * ASCII. Use the overload that takes a pointer for UTF-8 text.
+     */
+    token_category_e classify_char(char c) noexcept;
+
+    /**
+     * @brief Returns the number of bytes of the UTF-8 character that starts at `p`.
+     *
+     * Bytes that are not part of a well-formed UTF-8 sequence are characters on their own.
+     *
+     * @param p Start of the character, must be before `last`.
+     * @param last End of the text, characters at or after `last` are never accessed.
+     */
+    std::size_t char_size(const char* p, const char* last) noexcept;
+
+    /**
+     * @brief Returns the category of the UTF-8 character that starts at `p`.
+     *
+     * Besides the ASCII characters of classify_char(char), the Unicode whitespace
+     * (e.g. no-break space) is space, and the letters of the main scripts (Latin,
+     * Greek, Cyrillic, Arabic, Hebrew, CJK, kana, hangul, ...) along with their
+     * combining marks are alpha. Bytes that are not well-formed UTF-8 are other.
+     *
+     * @param p Start of the character, must be before `last`.
+     * @param last End of the text, characters at or after `last` are never accessed.
+     */
+    token_category_e classify_char(const char* p, const char* last) noexcept;
+
+    /**
+     * @brief Returns the start of the UTF-8 character that contains the byte at `p`.
+     *
+     * @param first Start of the text, which is the start of a character.
+     * @param p Byte of the character, must be within [first, last).
+     * @param last End of the text.
+     */
+    const char* char_begin(const char* first, const char* p, const char* last) noexcept;
+
+    /**
+     * @brief Returns the start of the last token of the text [first, last).
+     *
+     * That is the start of the last run of characters with the same category, or
+     * `last` if the text is empty.
+     */
+    const char* token_begin(const char* first, const char* last) noexcept;
+
+    /**
+     * @brief Returns the number of bytes at the end of the text [first, last) that
+     *        are the beginning of a UTF-8 character that is not complete.
+     *
+     * When text is split in blocks, these bytes belong with the next block.
+     */
+    std::size_t incomplete_char_size(const char* first, const char* last) noexcept;
+
+    /// Returns the instruction set of the kernel selected for this machine.
+    char_class_isa_e char_class_isa() noexcept;
+
+    /// Returns whether the kernel for `isa` can be executed in this machine.
+    bool char_class_isa_supported(char_class_isa_e isa) noexcept;
+
+    /// Returns the name of `isa`, for diagnostic purposes.
+    const char* char_class_isa_name(char_class_isa_e isa) noexcept;
+
+    /**
+     * @brief Classifies the char_class_block characters starting at `p`.
+     *
+     * Uses the kernel returned by char_class_isa().
+     */
+    char_class_masks_t classify_block(const char* p) noexcept;
+
+    /**
+     * @brief Classifies the char_class_block characters starting at `p` with a given kernel.
+     *
+     * @pre char_class_isa_supported(isa)
+     */
+    char_class_masks_t classify_block(const char* p, char_class_isa_e isa) noexcept;
+
+    /**
+     * @brief Finds token boundaries within a text, one block of characters at a time.
+     *
+     * Each block of char_class_block characters is classified once, and the positions
+     * where the category changes are kept in a bitmask, so finding the end of
+     * consecutive tokens of the same block is just a matter of bit scanning.
+     *
+     * Blocks that only have ASCII characters are fully classified by the vectorized
+     * kernel, otherwise the multi-byte characters are decoded and every byte of a
+     * character is given its category, so tokens never split a character.
+     *
+     * @note The scanner caches the last classified block, so reset() must be called
+     *   whenever the underlying text is modified.
+     */
+    class token_scanner_t {
+    public:
+        token_scanner_t() noexcept : base_(nullptr), boundaries_(0), alpha_starts_(0) {}
+
+        /// Forgets the cached block.
+        void reset() noexcept { base_ = nullptr; }
+
+        /**
+         * @brief Returns the end of the token that starts at `first`.
+         *
+         * The token is the run of characters with the same category as the one at `first`.
+         *
+         * @param first Start of the token, must be the start of a character.
+         * @param last End of the text, characters at or after `last` are never accessed.
+         */
+        const char* token_end(const char* first, const char* last) noexcept;
+
+        /**
+         * @brief Returns the start of the first alpha token that starts at or after `p`.
+         *
+         * Blocks without alpha tokens are skipped at once, so the tokens in between
+         * are never visited.
+         *
+         * @param first Start of the text, which is the start of a token.
+         * @param p Where the token is searched from, must be the start of a character.
+         * @param last End of the text, characters at or after `last` are never accessed.
+         * @returns The start of the token, or `last` if there is none.
+         */
+        const char* next_alpha_token(const char* first, const char* p, const char* last) noexcept;
+
+    private:
+        /// Classifies the block starting at `base` and computes its boundaries.
+        void load(const char* base, const char* text_first, const char* last) noexcept;
+
+        const char* base_;          //!< Start of the cached block.
+        std::uint64_t boundaries_;  //!< Bit `i` is set if a token starts at `base_[i]`.
+        std::uint64_t alpha_starts_;//!< Bit `i` is set if an alpha token starts at `base_[i]`.
+    };
+
+}
+
+#endif // INCLUDE_GUARD__CHAR_CLASS_H__GUID_d0b5a7e24c8f4f6f9a3e1b72c64d8e15
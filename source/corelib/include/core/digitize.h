@@ -1,7 +1,16 @@
 #ifndef INCLUDE_GUARD__DIGITIZE_H__GUID_2f2d7b62d36544a3bd505f8f5d8a53e2
 #define INCLUDE_GUARD__DIGITIZE_H__GUID_2f2d7b62d36544a3bd505f8f5d8a53e2
 
+#include "core/edits.h"
+#include "core/stats.h"
+#include "core/token_stream.h"
+
+#include "absl/strings/string_view.h"
+
 #include <iosfwd>
+#include <cstddef>
+#include <string>
+#include <chrono>
 
 namespace core {
 
@@ -11,9 +20,263 @@ namespace core {
      *
      * @param is Input stream that will be consumed.
      * @param os Output stream where resulting text will be written to.
+     * @param stats Where the stats of the conversion are added, if not nullptr.
+     */
+    void convert(std::istream& is, std::ostream& os, stats_t* stats = nullptr) noexcept;
+
+    /**
+     * @brief Replace each occurrance of a textual number in `in` to digits and output
+     *        the modified text to `os`.
+     *
+     * Unlike the istream overload, the text is not copied while being tokenized, and
+     * the text that is not part of a textual number is written straight from `in`.
+     * This is the preferred overload for memory mapped files (see mapped_file_t).
+     *
+     * @param in Input text.
+     * @param os Output stream where resulting text will be written to.
+     * @param stats Where the stats of the conversion are added, if not nullptr.
+     */
+    void convert(absl::string_view in, std::ostream& os, stats_t* stats = nullptr) noexcept;
+
+    /**
+     * @brief Replace each occurrance of a textual number in `in` to digits and write
+     *        the modified text at `out`, which may overlap `in`.
+     *
+     * No textual number is shorter than its digits, even counting the newline that is
+     * written when it spans several lines (the longest digits for the shortest text
+     * are those of "a million"), so the output never overtakes the text still to be
+     * read and the text can be converted over itself (see rewrite_file()).
+     *
+     * @param in Input text.
+     * @param out Where the resulting text is written, either outside of `in` or not
+     *  after its start, with room for `in.size()` characters.
+     * @param stats Where the stats of the conversion are added, if not nullptr.
+     * @returns The size of the resulting text, which is never larger than `in`.
+     */
+    std::size_t convert_in_place(absl::string_view in, char* out, stats_t* stats = nullptr) noexcept;
+
+    /**
+     * @brief Converts many texts, reusing the same resources for all of them.
+     *
+     * Each call to the free convert() functions sets up its own token storage, which
+     * dominates the cost of converting short texts. A converter_t keeps it, along with
+     * the capacity of the output string, between calls, so converting texts of
+     * similar size does not allocate in steady state.
+     *
+     * @note A converter_t must not be used by several threads at the same time, but
+     *   different instances can be used concurrently, e.g. one per thread.
+     */
+    class converter_t {
+    public:
+        converter_t() noexcept;
+
+        converter_t(const converter_t&) = delete;
+        converter_t& operator=(const converter_t&) = delete;
+
+        /**
+         * @brief Replace each occurrance of a textual number in `in` to digits and store
+         *        the modified text in `out`.
+         *
+         * @param in Input text.
+         * @param out String whose contents are replaced by the resulting text.
+         */
+        void convert(absl::string_view in, std::string& out) noexcept;
+
+        /// Same as convert(), but adds the stats of the conversion to `stats`.
+        void convert(absl::string_view in, std::string& out, stats_t& stats) noexcept;
+
+        /**
+         * @brief Replace each occurrance of a textual number in `in` to digits and write
+         *        the modified text at `out`, see convert_in_place().
+         *
+         * @param in Input text.
+         * @param out Where the resulting text is written, either outside of `in` or not
+         *  after its start, with room for `in.size()` characters.
+         * @returns The size of the resulting text, which is never larger than `in`.
+         */
+        std::size_t convert(absl::string_view in, char* out) noexcept;
+
+        /// Same as convert(), but adds the stats of the conversion to `stats`.
+        std::size_t convert(absl::string_view in, char* out, stats_t& stats) noexcept;
+
+        /**
+         * @brief Finds the textual numbers of `in` and stores the edits that convert
+         *        them, see find_edits().
+         *
+         * @param in Input text.
+         * @param offset Offset of `in` in the whole text, added to the offsets of the edits.
+         * @param format Encoding of the edits.
+         * @param out String whose contents are replaced by the encoded edits, without
+         *  the header of binary scripts.
+         */
+        void find_edits(absl::string_view in, std::uint64_t offset, edit_format_e format, std::string& out) noexcept;
+
+        /// Same as find_edits(), but adds the stats of the conversion to `stats`.
+        void find_edits(absl::string_view in, std::uint64_t offset, edit_format_e format, std::string& out, stats_t& stats) noexcept;
+
+    private:
+        token_stream_t stream_;     //!< Token storage, restarted for every text.
+    };
+
+    /**
+     * @brief Converts a text that is pushed in chunks, e.g. as it arrives from a socket.
+     *
+     * Chunks may split the text anywhere, even within a token or a textual number,
+     * so the state of the conversion is kept between calls to feed(). The converted
+     * text is returned as soon as no further input can change it, which is right
+     * after any text that cannot start a textual number (see rfind_split_point()),
+     * and at most max_lookahead tokens behind the input otherwise. The rest is
+     * returned once finish() is called. Concatenating all the outputs gives the same
+     * text as convert() on the whole input, and no call ever blocks.
+     */
+    class push_converter_t {
+    public:
+        push_converter_t() noexcept;
+
+        push_converter_t(const push_converter_t&) = delete;
+        push_converter_t& operator=(const push_converter_t&) = delete;
+
+        /**
+         * @brief Pushes the next chunk of the input.
+         *
+         * @param chunk Next characters of the input, which are copied as needed.
+         * @param out String whose contents are replaced by the converted text that
+         *   became final, which may be empty.
+         */
+        void feed(absl::string_view chunk, std::string& out) noexcept;
+
+        /// Same as feed(), but adds the stats of the conversion to `stats`.
+        void feed(absl::string_view chunk, std::string& out, stats_t& stats) noexcept;
+
+        /**
+         * @brief Signals the end of the input.
+         *
+         * The converter can then be reused for another input.
+         *
+         * @param out String whose contents are replaced by the rest of the converted text.
+         */
+        void finish(std::string& out) noexcept;
+
+        /// Same as finish(), but adds the stats of the conversion to `stats`.
+        void finish(std::string& out, stats_t& stats) noexcept;
+
+        /// Returns whether part of the input has not been converted yet.
+        bool has_pending() const noexcept { return !pending_.empty(); }
+
+    private:
+        /// Implementation of feed(), `Stats` is either stats_t or null_stats_t.
+        template<typename Stats>
+        void feed_chunk(absl::string_view chunk, std::string& out, Stats& stats) noexcept;
+
+        /// Implementation of finish(), `Stats` is either stats_t or null_stats_t.
+        template<typename Stats>
+        void finish_input(std::string& out, Stats& stats) noexcept;
+
+        std::string pending_;       //!< Input that has not been converted yet.
+        std::size_t complete_;      //!< Size of the prefix of pending_ that only has complete tokens.
+        token_stream_t stream_;     //!< Token storage, restarted for every chunk.
+    };
+
+    /// Default size of the chunks converted in parallel, see convert().
+    constexpr std::size_t default_chunk_size = 4 * 1024 * 1024;
+
+    /**
+     * @brief Replace each occurrance of a textual number in `in` to digits and output
+     *        the modified text to `os`, using several threads.
+     *
+     * The text is split in chunks of about `chunk_size` characters at points that no
+     * textual number can span (see find_split_point()), which are converted by a pool
+     * of `jobs` threads and written to `os` in order. The result is identical to the
+     * single threaded convert().
+     *
+     * @param in Input text.
+     * @param os Output stream where resulting text will be written to.
+     * @param jobs Number of threads, 0 for one per hardware thread.
+     * @param chunk_size Approximate size of each chunk in characters.
+     * @param stats Where the stats of the conversion are added, if not nullptr.
+     */
+    void convert(absl::string_view in, std::ostream& os, std::size_t jobs, std::size_t chunk_size = default_chunk_size, stats_t* stats = nullptr) noexcept;
+
+    /**
+     * @brief Finds each occurrance of a textual number in `is` and outputs the edit
+     *        script that replaces them to digits to `os`, see edit_format_e.
+     *
+     * The script has an edit per textual number, so its size depends on the number
+     * of textual numbers instead of the size of the text, and applying it to the
+     * text (see apply_edits()) gives the same text as convert().
+     *
+     * @param is Input stream that will be consumed.
+     * @param os Output stream where the edit script will be written to.
+     * @param format Encoding of the edit script.
+     * @param stats Where the stats of the conversion are added, if not nullptr.
+     */
+    void find_edits(std::istream& is, std::ostream& os, edit_format_e format, stats_t* stats = nullptr) noexcept;
+
+    /**
+     * @brief Finds each occurrance of a textual number in `in` and outputs the edit
+     *        script that replaces them to digits to `os`, using several threads.
+     *
+     * As with the parallel convert(), the text is split in chunks at split points,
+     * whose edits are found by a pool of `jobs` threads and written to `os` in order.
+     *
+     * @param in Input text.
+     * @param os Output stream where the edit script will be written to.
+     * @param format Encoding of the edit script.
+     * @param jobs Number of threads, 0 for one per hardware thread.
+     * @param chunk_size Approximate size of each chunk in characters.
+     * @param stats Where the stats of the conversion are added, if not nullptr.
+     */
+    void find_edits(absl::string_view in, std::ostream& os, edit_format_e format, std::size_t jobs = 1,
+                    std::size_t chunk_size = default_chunk_size, stats_t* stats = nullptr) noexcept;
+
+    /// Default number of elements between pipeline stages, see convert_pipelined().
+    constexpr std::size_t default_queue_depth = 8;
+
+    /**
+     * @brief Replace each occurrance of a textual number in `is` to digits and output
+     *        the modified text to `os`, overlapping input, conversion and output.
+     *
+     * The work is split in four stages, each one on its own thread: reading `is` in
+     * blocks, cutting the blocks into chunks at split points (see find_split_point()),
+     * matching the textual numbers of each chunk, and writing the converted chunks to
+     * `os`. Stages are connected by bounded queues (see spsc_queue_t), so a slow stage
+     * stalls the previous ones instead of buffering the whole input. The result is
+     * identical to the single threaded convert().
+     *
+     * @param is Input stream that will be consumed.
+     * @param os Output stream where resulting text will be written to.
+     * @param queue_depth Maximum number of blocks or chunks waiting between two stages,
+     *   which caps the memory used to roughly 3 * queue_depth blocks of
+     *   token_stream_t::block_size characters.
+     * @param stats Where the stats of the conversion are added, if not nullptr. The
+     *   time of each stage is the time its thread has been busy, so they overlap.
+     */
+    void convert_pipelined(std::istream& is, std::ostream& os, std::size_t queue_depth = default_queue_depth, stats_t* stats = nullptr) noexcept;
+
+    /// Default maximum time a possible textual number is held, see convert_interactive().
+    constexpr std::chrono::milliseconds default_max_hold{ 100 };
+
+    /**
+     * @brief Replace each occurrance of a textual number in `is` to digits and output
+     *        the modified text to `os` with bounded latency, e.g. for live pipes.
+     *
+     * The input is read as soon as it is available, instead of waiting for whole
+     * blocks, and converted with a push_converter_t, so any text that cannot be part
+     * of a textual number is written right away. `os` is flushed whenever a line is
+     * completed.
+     *
+     * Text that may still be part of a textual number is held until the input that
+     * decides it arrives, but never longer than `max_hold`. Once that time passes, the
+     * held text is converted as if the input ended there, so a textual number that is
+     * completed afterwards is converted in two parts.
+     *
+     * @param is Input stream that will be consumed.
+     * @param os Output stream where resulting text will be written to.
+     * @param max_hold Maximum time any text is held before being written.
+     * @param stats Where the stats of the conversion are added, if not nullptr.
      */
-    void convert(std::istream& is, std::ostream& os) noexcept;
+    void convert_interactive(std::istream& is, std::ostream& os, std::chrono::milliseconds max_hold = default_max_hold, stats_t* stats = nullptr) noexcept;
 
 }
 
-#endif // INCLUDE_GUARD__DIGITIZE_H__GUID_2f2d7b62d36544a3bd505f8f5d8a53e2
\ No newline at end of file
+#endif // INCLUDE_GUARD__DIGITIZE_H__GUID_2f2d7b62d36544a3bd505f8f5d8a53e2
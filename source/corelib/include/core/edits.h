@@ -0,0 +1,97 @@
+#ifndef INCLUDE_GUARD__EDITS_H__GUID_409687c95752437b96f09c4138f64048
+#define INCLUDE_GUARD__EDITS_H__GUID_409687c95752437b96f09c4138f64048
+
+#include "absl/strings/string_view.h"
+
+#include <iosfwd>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace core {
+
+    /**
+     * @brief Encodings of an edit script, see find_edits().
+     *
+     * A binary script starts with the 8 characters of edit_magic, followed by a
+     * record of edit_record_size bytes per edit: its offset, length, value and
+     * flags, each as 8 bytes in little endian. The only flag is bit 0, set if a
+     * newline is written before the digits.
+     *
+     * A jsonl script has a JSON object per edit and line, e.g.
+     * `{"offset":4,"length":9,"value":42}`, with `"newline":true` if the flag is set.
+     */
+    enum class edit_format_e {
+        binary,     //!< Fixed size records, for programs that map the script.
+        jsonl       //!< A JSON object per line, for programs that read text.
+    };
+
+    /// First characters of a binary edit script.
+    constexpr absl::string_view edit_magic{ "w2dedit1", 8 };
+
+    /// Size in bytes of each edit of a binary edit script.
+    constexpr std::size_t edit_record_size = 32;
+
+    /**
+     * @brief Replacement of a textual number of a text by its digits.
+     */
+    struct edit_t {
+        std::uint64_t offset;   //!< Offset in bytes of the textual number in the original text.
+        std::uint64_t length;   //!< Size in bytes of the textual number.
+        std::uint64_t value;    //!< Value of the textual number, written in its place.
+        bool newline;           //!< Whether a newline is written before the digits, as the textual number spans lines.
+    };
+
+    /// Appends the encoding of `edit` in `format` to `out`.
+    void append_edit(std::string& out, const edit_t& edit, edit_format_e format) noexcept;
+
+    /**
+     * @brief Reads the edits of an edit script, in either format.
+     *
+     * The format is told by the first character of the script, which is that of
+     * edit_magic for binary scripts and '{' for jsonl ones.
+     */
+    class edit_reader_t {
+    public:
+        /// Constructs a reader of the script in `is`, which must outlive it.
+        explicit edit_reader_t(std::istream& is) noexcept;
+
+        /**
+         * @brief Reads the next edit.
+         *
+         * @returns true if an edit was read, false at the end of the script or if
+         *  the script is malformed, see failed().
+         */
+        bool next(edit_t& edit) noexcept;
+
+        /// Returns whether the script is malformed.
+        bool failed() const noexcept { return failed_; }
+
+    private:
+        std::istream* is_;      //!< Script being read.
+        edit_format_e format_;  //!< Format of the script.
+        std::string line_;      //!< Last line of a jsonl script.
+        bool failed_;           //!< Whether the script is malformed.
+    };
+
+    /**
+     * @brief Applies the edit script in `edits` to the original text in `in` and
+     *        outputs the resulting text to `os`.
+     *
+     * Applying the edits found in a text (see find_edits()) gives the same text as
+     * converting it (see convert()).
+     *
+     * @param in Original text.
+     * @param edits Edit script, whose edits must be sorted by offset and not overlap.
+     * @param os Output stream where resulting text will be written to.
+     * @returns true on success, false if the script is malformed or does not fit
+     *  the text, in which case the output is only written up to the failing edit.
+     */
+    bool apply_edits(absl::string_view in, std::istream& edits, std::ostream& os) noexcept;
+
+    /// Same as apply_edits(), but the original text is read from `is`.
+    bool apply_edits(std::istream& is, std::istream& edits, std::ostream& os) noexcept;
+
+}
+
+#endif // INCLUDE_GUARD__EDITS_H__GUID_409687c95752437b96f09c4138f64048
@@ -2,8 +2,13 @@
 #define INCLUDE_GUARD__GRAMMAR_H__GUID_2f67ead557e14b0abbcb5be53288968c
 
 #include "token_stream.h"
+#include "stats.h"
+#include "core/grammar_variants.h"
+
+#include "absl/strings/string_view.h"
 
 #include <cstdint>
+#include <cstddef>
 
 namespace core {
 
@@ -22,33 +27,79 @@ namespace core {
     };
 
     /**
-     * @brief Returns if there is a textual number at current token of `it`.
+     * @brief Maximum number of tokens match_cardinal_number may examine, starting by the current one.
+     *
+     * The longest match of the british variant is a Millions with Thousands at both
+     * sides of 'million', that is 21 + 3 + 21 = 45 tokens, after which the automaton
+     * may check for a Space and a scale word in order to be greedy. The generated
+     * matchers of other variants may need more, see grammar_variants_lookahead.
+     */
+    constexpr std::size_t max_lookahead = grammar_variants_lookahead > 47 ? grammar_variants_lookahead : 47;
+
+    /**
+     * @brief Implementations of the grammar matcher.
      *
-     * Starting by the current token `it`, tries to match a textual number.
-     * This function analyzes the following grammar:
+     * Both engines give the same results, they only differ on performance.
+     */
+    enum class grammar_engine_e {
+        recursive_descent,  //!< Recursive descent rules generated from the grammar description, may examine tokens several times.
+        automaton           //!< Table-driven automaton, examines each token once, only for the british variant.
+    };
+
+    /**
+     * @brief Selects the variant matched when none is given, default_grammar_variant
+     *        until then.
+     *
+     * It applies to the whole process, so it is meant to be set once, before any
+     * conversion starts.
+     */
+    void set_grammar_variant(grammar_variant_e variant) noexcept;
+
+    /// Returns the variant matched when none is given, see set_grammar_variant().
+    grammar_variant_e grammar_variant() noexcept;
+
+    /// Returns the name of `variant`, as in the grammar description.
+    const char* grammar_variant_name(grammar_variant_e variant) noexcept;
+
+    /// Finds the variant named `name`, returns false if there is none.
+    bool find_grammar_variant(absl::string_view name, grammar_variant_e& variant) noexcept;
+
+    /**
+     * @brief Returns if there is a textual number at current token of `it`.
      *
-     *     CardNum      -> 'zero' | Millions | AValue
-     *     Digit        -> 'one' | 'two' | 'three' | 'four' | 'five' | 'six' | 'seven' | 'eight' | 'nine'
-     *     Teens        ->  'ten' | 'eleven' | 'twelve'  | 'thirteen' | 'fourteen' | 'fifteen' | 'sixteen' | 'seventeen' | 'eighteen' | 'nineteen'
-     *     SecDig       -> 'twenty' | 'thirty' | 'forty' | 'fifty' | 'sixty' | 'seventy' | 'eighty' | 'ninety'
-     *     Below100     -> Digit | Teens | SecDig | SecDig '-' Digit
-     *     HundredSfx   -> 'hundred' | 'hundred and ' Below100
-     *     Hundreds     -> Below100 | Digit ' ' HundredSfx
-     *     ThousandSfx  -> 'thousand' | 'thousand ' Hundreds
-     *     Thousands    -> Hundreds | Hundreds ' ' ThousandSfx
-     *     MillionSfx   -> 'million' | 'million ' Thousands
-     *     Millions     -> Thousands | Thousands ' ' MillionSfx
-     *     AValue       -> 'a ' HundredSfx | 'a ' ThousandSfx | 'a hundred ' ThousandSfx | 'a ' MillionSfx | 'a hundred ' MillionSfx
+     * Starting by the current token `it`, tries to match a textual number of the
+     * variant selected with set_grammar_variant().
      *
-     * Where a whitespace represent a space token, see token_category_enum_t.
+     * The variants are described in `source/corelib/grammar/cardinal.grammar`, from
+     * which `tools/grammar_gen.py` generates a function template per rule and variant
+     * at build time. The rule templates are inlined into each other, so matching a
+     * variant costs a single switch on top of a hand-written matcher, and adding a
+     * variant only takes a few lines of the description. The british variant is the
+     * grammar of the README.
      *
-     * @note This function will increment the iterator, which have some side-effects
-    *        on the referred token_sequence_t.
+     * @note This function will look ahead up to max_lookahead tokens from the iterator,
+    *        which have some side-effects on the referred token_sequence_t. The rules
+    *        index the contiguous records of these tokens (see token_record_t), so they
+    *        never call back into the stream.
     *
     * @param it The token from which the algorithm will try to match a textual number.
+    * @param engine Implementation used to match the grammar.
     * @returns An empty match (size=0) if no match occurred, the actual match otherwise.
     */
-    match_t match_cardinal_number(forward_token_iterator_t it) noexcept;
+    match_t match_cardinal_number(forward_token_iterator_t it, grammar_engine_e engine = grammar_engine_e::automaton) noexcept;
+
+    /**
+     * @brief Same as match_cardinal_number(), but counts the match attempt and the
+     *        tokens examined by each rule of the grammar in `stats`.
+     */
+    match_t match_cardinal_number(forward_token_iterator_t it, grammar_engine_e engine, stats_t& stats) noexcept;
+
+    /**
+     * @brief Same as match_cardinal_number(), but matches `variant` rather than the
+     *        selected one. The automaton is only used for the british variant.
+     */
+    match_t match_cardinal_number(forward_token_iterator_t it, grammar_variant_e variant,
+                                  grammar_engine_e engine = grammar_engine_e::automaton) noexcept;
 
 }
 
@@ -0,0 +1,77 @@
+#ifndef INCLUDE_GUARD__KEYWORD_H__GUID_5a8e2c913f6d4b07a1c4e9d27b30f6a8
+#define INCLUDE_GUARD__KEYWORD_H__GUID_5a8e2c913f6d4b07a1c4e9d27b30f6a8
+
+#include "absl/strings/string_view.h"
+
+#include <cstdint>
+
+namespace core {
+
+    /**
+     * @brief The words (and symbols) of the cardinal numbers grammar.
+     *
+     * Tokens are resolved to a keyword when they are tokenized, so that the
+     * grammar only compares small integers. The numeric keywords are sorted
+     * by value, so that the classes of the grammar (Digit, Teens, SecDig) are
+     * contiguous ranges.
+     */
+    enum class keyword_e : std::uint8_t {
+        none,       //!< The token is not a keyword.
+        zero,
+        one, two, three, four, five, six, seven, eight, nine,
+        ten, eleven, twelve, thirteen, fourteen, fifteen, sixteen, seventeen, eighteen, nineteen,
+        twenty, thirty, forty, fifty, sixty, seventy, eighty, ninety,
+        hundred,
+        thousand,
+        million,
+        a,
+        and_,       //!< The word 'and', suffixed as `and` is a reserved word.
+        hyphen,     //!< The symbol '-'.
+        count_      //!< Number of keywords, not a keyword.
+    };
+
+    /**
+     * @brief Returns the keyword of a token, ignoring case, or keyword_e::none.
+     *
+     * Works on the raw text of the token, so it does not need to be normalized.
+     * Most words are rejected by their length or their first letter, and the rest
+     * are looked up with a perfect hash over the fixed lexicon of the grammar, so
+     * at most a single keyword is compared with the text.
+     */
+    keyword_e find_keyword(absl::string_view text) noexcept;
+
+    /// Returns the text of keyword `k`.
+    absl::string_view keyword_text(keyword_e k) noexcept;
+
+    /// Returns the value of a numeric or scale keyword, 0 for the rest.
+    inline std::uint64_t keyword_value(keyword_e k) noexcept
+    {
+        static const std::uint64_t values[] = {
+            0,
+            0,
+            1, 2, 3, 4, 5, 6, 7, 8, 9,
+            10, 11, 12, 13, 14, 15, 16, 17, 18, 19,
+            20, 30, 40, 50, 60, 70, 80, 90,
+            100,
+            1000,
+            1000000,
+            0,
+            0,
+            0
+        };
+        static_assert(sizeof(values) / sizeof(values[0]) == static_cast<std::size_t>(keyword_e::count_), "a value is needed for each keyword");
+        return values[static_cast<std::size_t>(k)];
+    }
+
+    /// Returns whether `k` is one of the words of the Digit rule.
+    inline bool is_digit(keyword_e k) noexcept { return k >= keyword_e::one && k <= keyword_e::nine; }
+
+    /// Returns whether `k` is one of the words of the Teens rule.
+    inline bool is_teen(keyword_e k) noexcept { return k >= keyword_e::ten && k <= keyword_e::nineteen; }
+
+    /// Returns whether `k` is one of the words of the SecDig rule.
+    inline bool is_tens(keyword_e k) noexcept { return k >= keyword_e::twenty && k <= keyword_e::ninety; }
+
+}
+
+#endif // INCLUDE_GUARD__KEYWORD_H__GUID_5a8e2c913f6d4b07a1c4e9d27b30f6a8
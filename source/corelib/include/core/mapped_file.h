@@ -0,0 +1,67 @@
+#ifndef INCLUDE_GUARD__MAPPED_FILE_H__GUID_9c1d3e0b7a5f4e2d8b6a41f3c2e7d905
+#define INCLUDE_GUARD__MAPPED_FILE_H__GUID_9c1d3e0b7a5f4e2d8b6a41f3c2e7d905
+
+#include "absl/strings/string_view.h"
+
+#include <string>
+#include <cstddef>
+
+namespace core {
+
+    /**
+     * @brief Read-only memory mapping of a whole file.
+     *
+     * The contents of the file are exposed as a contiguous buffer, so that they
+     * can be tokenized without copying them (see token_stream_t).
+     *
+     * @note Memory mapping is only supported in POSIX systems, in any other
+     *   system open() always fails and the caller is expected to fall back
+     *   to regular streams.
+     */
+    class mapped_file_t {
+    public:
+        /// Constructs an object that does not map any file.
+        mapped_file_t() noexcept;
+
+        /// Unmaps the file, if any.
+        ~mapped_file_t();
+
+        mapped_file_t(const mapped_file_t&) = delete;
+        mapped_file_t& operator=(const mapped_file_t&) = delete;
+
+        /**
+         * @brief Maps the file at `path`.
+         *
+         * Any previously mapped file is unmapped.
+         *
+         * @param path Path to the file to map.
+         * @returns true on success, false otherwise.
+         */
+        bool open(const std::string& path) noexcept;
+
+        /// Unmaps the file, if any.
+        void close() noexcept;
+
+        /// Returns whether a file is mapped.
+        bool is_open() const noexcept { return open_; }
+
+        /// Returns the contents of the mapped file.
+        absl::string_view view() const noexcept { return { data_, size_ }; }
+
+        /**
+         * @brief Returns whether `path` refers to a regular file.
+         *
+         * Only regular files can be mapped, other files (pipes, character devices, ...)
+         * must be read with streams.
+         */
+        static bool is_regular_file(const std::string& path) noexcept;
+
+    private:
+        const char* data_;  //!< Start of the mapping.
+        std::size_t size_;  //!< Size of the mapping in bytes.
+        bool open_;         //!< Whether a file is mapped.
+    };
+
+}
+
+#endif // INCLUDE_GUARD__MAPPED_FILE_H__GUID_9c1d3e0b7a5f4e2d8b6a41f3c2e7d905
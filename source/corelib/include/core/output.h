@@ -0,0 +1,92 @@
+#ifndef INCLUDE_GUARD__OUTPUT_H__GUID_b3f81d6a0c2e4a97b5d41e8f09c6a273
+#define INCLUDE_GUARD__OUTPUT_H__GUID_b3f81d6a0c2e4a97b5d41e8f09c6a273
+
+#include "absl/strings/string_view.h"
+
+#include <iosfwd>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+namespace core {
+
+    /// Maximum number of digits of an std::uint64_t.
+    constexpr std::size_t max_uint_digits = 20;
+
+    /**
+     * @brief Writes the decimal digits of `n` at `out`, without a terminating null.
+     *
+     * Digits are produced two at a time from a lookup table of the pairs "00" to "99".
+     *
+     * @param n Number to format.
+     * @param out Buffer of at least max_uint_digits characters.
+     * @returns The number of characters written.
+     */
+    std::size_t format_uint(std::uint64_t n, char* out) noexcept;
+
+    /**
+     * @brief Collects the output of a conversion into large blocks.
+     *
+     * Every write to an std::ostream goes through a virtual call and its sentry, which
+     * is as expensive as matching the grammar when the text has many short tokens.
+     * An output_buffer_t copies the writes into a block instead, which is written to
+     * the stream with a single call once it is full. Texts that do not fit in the
+     * block are written directly after the pending contents, without copying them.
+     *
+     * @note The buffer is flushed on destruction, but flush() must be called
+     *   beforehand if the stream is to be used meanwhile.
+     */
+    class output_buffer_t {
+    public:
+        /// Default size of the block, in characters.
+        static constexpr std::size_t default_block_size = 64 * 1024;
+
+        /**
+         * @brief Constructs a buffer that writes to `os`.
+         *
+         * @param os Stream where the blocks are written, must outlive the buffer.
+         * @param block_size Size of the block, at least max_uint_digits characters.
+         */
+        explicit output_buffer_t(std::ostream& os, std::size_t block_size = default_block_size) noexcept;
+
+        /// Flushes the pending contents.
+        ~output_buffer_t();
+
+        output_buffer_t(const output_buffer_t&) = delete;
+        output_buffer_t& operator=(const output_buffer_t&) = delete;
+
+        /// Appends `text`.
+        void write(absl::string_view text) noexcept
+        {
+            if (text.size() <= block_.size() - size_) {
+                std::memcpy(block_.data() + size_, text.data(), text.size());
+                size_ += text.size();
+            }
+            else {
+                write_large(text);
+            }
+        }
+
+        /// Appends the decimal digits of `n`.
+        void write(std::uint64_t n) noexcept
+        {
+            if (block_.size() - size_ < max_uint_digits) flush();
+            size_ += format_uint(n, block_.data() + size_);
+        }
+
+        /// Writes the pending contents to the stream.
+        void flush() noexcept;
+
+    private:
+        /// Appends a text that does not fit in the remaining space of the block.
+        void write_large(absl::string_view text) noexcept;
+
+        std::ostream* os_;          //!< Where the blocks are written.
+        std::vector<char> block_;   //!< Pending contents, the first size_ characters.
+        std::size_t size_;          //!< Number of pending characters.
+    };
+
+}
+
+#endif // INCLUDE_GUARD__OUTPUT_H__GUID_b3f81d6a0c2e4a97b5d41e8f09c6a273
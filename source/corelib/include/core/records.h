@@ -0,0 +1,128 @@
+#ifndef INCLUDE_GUARD__RECORDS_H__GUID_0fa59d7d9aa044a0912cfc86663368ae
+#define INCLUDE_GUARD__RECORDS_H__GUID_0fa59d7d9aa044a0912cfc86663368ae
+
+#include "core/digitize.h"
+#include "core/stats.h"
+
+#include "absl/strings/string_view.h"
+
+#include <iosfwd>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace core {
+
+    /**
+     * @brief Formats of the records of record_converter_t.
+     */
+    enum class record_format_e {
+        csv,    //!< Comma separated values, fields may be quoted with '"', quotes are escaped by doubling them.
+        tsv,    //!< Tab separated values, fields are never quoted.
+        jsonl   //!< A JSON value per line, usually an object.
+    };
+
+    /**
+     * @brief The fields of the records whose textual numbers are converted.
+     */
+    struct record_fields_t {
+        record_format_e format;             //!< Format of the records.
+        std::vector<std::size_t> columns;   //!< Columns of csv and tsv records, starting by 0, all of them if empty.
+        std::vector<std::string> keys;      //!< Keys of the string values of the top-level jsonl objects, all of them if empty.
+    };
+
+    /**
+     * @brief Converts the textual numbers of some fields of structured records.
+     *
+     * Only the selected fields are tokenized and matched (see record_fields_t), and
+     * every other byte is copied untouched, which is faster than converting the whole
+     * records and never alters their structure, e.g. keys or numeric columns.
+     *
+     * The structure is found by jumping from a delimiter to the next with memchr(),
+     * which is vectorized by the C library. For csv and tsv, a field is the text
+     * between delimiters, without the quotes of quoted fields. For jsonl, a field is
+     * the raw text of a string value of a top-level object, so escaped characters are
+     * not decoded, and are treated as any other punctuation by the grammar.
+     *
+     * As textual numbers never contain delimiters or quotes, and a newline is only
+     * written before a number that spans lines, the converted fields never break the
+     * structure of the records.
+     *
+     * @note A record_converter_t must not be used by several threads at the same time,
+     *   but different instances can be used concurrently, e.g. one per thread.
+     */
+    class record_converter_t {
+    public:
+        /// Constructs a converter of `fields`, which must outlive it.
+        explicit record_converter_t(const record_fields_t& fields) noexcept;
+
+        record_converter_t(const record_converter_t&) = delete;
+        record_converter_t& operator=(const record_converter_t&) = delete;
+
+        /**
+         * @brief Converts the selected fields of `in`, which holds whole records.
+         *
+         * @param in Records to convert.
+         * @param out String whose contents are replaced by the resulting records.
+         */
+        void convert(absl::string_view in, std::string& out) noexcept;
+
+        /// Same as convert(), but adds the stats of the conversion of the fields to `stats`.
+        void convert(absl::string_view in, std::string& out, stats_t& stats) noexcept;
+
+    private:
+        /// Implementation of convert(), `Stats` is either stats_t or null_stats_t.
+        template<typename Stats>
+        void convert_records(absl::string_view in, std::string& out, Stats& stats) noexcept;
+
+        /// Appends the conversion of `field` to `out`.
+        template<typename Stats>
+        void convert_field(absl::string_view field, std::string& out, Stats& stats) noexcept;
+
+        /// Converts the csv or tsv record that starts at `first`, returns the start of the next one.
+        template<typename Stats>
+        const char* convert_separated(const char* first, const char* last, std::string& out, Stats& stats) noexcept;
+
+        /// Converts the jsonl record that starts at `first`, returns the start of the next one.
+        template<typename Stats>
+        const char* convert_json(const char* first, const char* last, std::string& out, Stats& stats) noexcept;
+
+        /// Returns whether the string value of `key` is converted.
+        bool selected_key(absl::string_view key) const noexcept;
+
+        const record_fields_t* fields_; //!< Fields to convert.
+        std::vector<bool> columns_;     //!< Whether each column is converted, empty if all of them are.
+        converter_t converter_;         //!< Converts the selected fields.
+    };
+
+    /**
+     * @brief Returns the first position at or after `pos` where a record of `text` starts.
+     *
+     * Records are split at newlines, except for the newlines within quoted csv fields,
+     * which are told by the parity of the quotes since `from`, which must be the start
+     * of a record.
+     *
+     * @returns The start of a record, or `text.size()` if there is none.
+     */
+    std::size_t find_record_start(absl::string_view text, record_format_e format, std::size_t from, std::size_t pos) noexcept;
+
+    /**
+     * @brief Converts the textual numbers of some fields of the records in `in` and
+     *        outputs the resulting records to `os`, see record_converter_t.
+     *
+     * The records are split in batches of about `batch_size` characters, which are
+     * converted by a pool of `jobs` threads and written to `os` in order.
+     *
+     * @param in Input records.
+     * @param os Output stream where the resulting records will be written to.
+     * @param fields Fields to convert.
+     * @param jobs Number of threads, 0 for one per hardware thread.
+     * @param batch_size Approximate size of each batch in characters.
+     * @param stats Where the stats of the conversion are added, if not nullptr.
+     */
+    void convert_records(absl::string_view in, std::ostream& os, const record_fields_t& fields, std::size_t jobs = 1,
+                         std::size_t batch_size = default_chunk_size, stats_t* stats = nullptr) noexcept;
+
+}
+
+#endif // INCLUDE_GUARD__RECORDS_H__GUID_0fa59d7d9aa044a0912cfc86663368ae
@@ -0,0 +1,45 @@
+#ifndef INCLUDE_GUARD__REWRITE_H__GUID_1a258b6367954d2db1e9e55ee24767d9
+#define INCLUDE_GUARD__REWRITE_H__GUID_1a258b6367954d2db1e9e55ee24767d9
+
+#include "core/stats.h"
+
+#include <string>
+#include <cstddef>
+
+namespace core {
+
+    /// Default size of the text that is rewritten between two records of the journal.
+    constexpr std::size_t default_segment_size = 16 * 1024 * 1024;
+
+    /**
+     * @brief Converts the file at `path` in place, without writing a second file.
+     *
+     * The file is memory mapped for reading and writing, the converted text is
+     * written over it from its start (see convert_in_place()), and then the file
+     * is truncated to the size of the converted text.
+     *
+     * With a journal, the text is rewritten in segments that end at split points
+     * (see find_split_point()). Before a segment is overwritten, its original text
+     * and the progress of the rewrite are saved to the journal and synced to disk,
+     * and the rewritten segment is synced before the next one is journaled. If the
+     * rewrite is interrupted, e.g. by a crash or a power loss, calling rewrite_file()
+     * again with the same journal restores the original text of the segment that was
+     * being rewritten, and resumes the rewrite from it. The journal is removed once
+     * the rewrite is complete.
+     *
+     * @note As with mapped_file_t, this is only supported in POSIX systems.
+     *
+     * @param path Path to the file to convert.
+     * @param journal Path to the journal, or empty for none, in which case an
+     *  interrupted rewrite leaves the file partially converted.
+     * @param stats Where the stats of the conversion are added, if not nullptr.
+     * @param segment_size Size of the text rewritten between two journal records.
+     * @returns true on success, false if the file or the journal could not be
+     *  accessed, or if the journal is of a rewrite of another file.
+     */
+    bool rewrite_file(const std::string& path, const std::string& journal = std::string(),
+                      stats_t* stats = nullptr, std::size_t segment_size = default_segment_size) noexcept;
+
+}
+
+#endif // INCLUDE_GUARD__REWRITE_H__GUID_1a258b6367954d2db1e9e55ee24767d9
@@ -0,0 +1,56 @@
+#ifndef INCLUDE_GUARD__SCHEDULER_H__GUID_e5a04c7b19d24f3e8c6b2a9071d3f58c
+#define INCLUDE_GUARD__SCHEDULER_H__GUID_e5a04c7b19d24f3e8c6b2a9071d3f58c
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+namespace core {
+
+    /**
+     * @brief Returns the number of threads that run_tasks() uses.
+     *
+     * @param count Number of tasks.
+     * @param jobs Requested number of threads, 0 for one per hardware thread.
+     */
+    std::size_t task_threads(std::size_t count, std::size_t jobs) noexcept;
+
+    /**
+     * @brief Runs the tasks 0 to `count - 1` on several threads, balancing them by work stealing.
+     *
+     * Tasks are dealt in order to a deque per thread, and every thread runs the
+     * tasks of its own deque from the front. A thread that runs out of tasks steals
+     * them from the back of the other deques, so a few long tasks never leave the
+     * other threads idle while there is work left. Tasks that are expected to be
+     * the longest should come first, so that they are not the last ones to start.
+     *
+     * @param count Number of tasks.
+     * @param jobs Requested number of threads, 0 for one per hardware thread. The
+     *   calling thread is one of them.
+     * @param task Runs a task, given its index and the index of the thread that runs
+     *   it, which is less than task_threads(count, jobs). It is called concurrently.
+     */
+    void run_tasks(std::size_t count, std::size_t jobs, const std::function<void(std::size_t, std::size_t)>& task) noexcept;
+
+    /**
+     * @brief Runs the tasks 0 to `count - 1` on several threads, and consumes their outputs in order.
+     *
+     * Workers take the tasks in order and produce a string for each of them, which
+     * the calling thread consumes in the order of the tasks as soon as it is ready.
+     * Workers never run more than two tasks per thread ahead of the last output
+     * consumed, which bounds the memory used by the outputs waiting to be consumed.
+     *
+     * @param count Number of tasks.
+     * @param jobs Requested number of worker threads, 0 for one per hardware thread.
+     * @param produce Runs a task, given its index, the index of the worker that runs
+     *   it, which is less than task_threads(count, jobs), and a string whose contents
+     *   are replaced by its output. It is called concurrently.
+     * @param consume Consumes the output of a task, given its index, on the calling thread.
+     */
+    void run_ordered_tasks(std::size_t count, std::size_t jobs,
+                           const std::function<void(std::size_t, std::size_t, std::string&)>& produce,
+                           const std::function<void(std::size_t, std::string&)>& consume) noexcept;
+
+}
+
+#endif // INCLUDE_GUARD__SCHEDULER_H__GUID_e5a04c7b19d24f3e8c6b2a9071d3f58c
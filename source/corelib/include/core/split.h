@@ -0,0 +1,62 @@
+#ifndef INCLUDE_GUARD__SPLIT_H__GUID_7e4b1f0c2a9d4c5e8f36d0a1b9e2c847
+#define INCLUDE_GUARD__SPLIT_H__GUID_7e4b1f0c2a9d4c5e8f36d0a1b9e2c847
+
+#include "absl/strings/string_view.h"
+
+#include <cstddef>
+
+namespace core {
+
+    /**
+     * @brief Returns the first position at or after `pos` where `text` can be split
+     *        without changing the result of converting it.
+     *
+     * That is, converting both parts separately and concatenating the results gives
+     * the same text as converting `text` whole. Such positions are the start of the
+     * tokens that cannot be part of any textual number (neither space nor keywords,
+     * see keyword_e), as no match can span them and the grammar treats them as it
+     * treats the end of the text.
+     *
+     * @param text Text to split.
+     * @param pos Position from which a split point is searched.
+     * @returns The split position, or `text.size()` if there is none.
+     */
+    std::size_t find_split_point(absl::string_view text, std::size_t pos) noexcept;
+
+    /**
+     * @brief Returns the last position of `text` up to which its conversion is final,
+     *        i.e. it does not depend on any text that may follow.
+     *
+     * That is the end of the last token that cannot be part of any textual number (see
+     * find_split_point()), or the start of the text if there is none, along with the
+     * spaces after it, as no textual number starts with a space. It is also a split
+     * point, so the text before it can be converted on its own.
+     *
+     * @param text Text to split, all whose tokens must be complete.
+     * @returns The split position, 0 if no part of the conversion is final.
+     */
+    std::size_t rfind_split_point(absl::string_view text) noexcept;
+
+    /**
+     * @brief Returns the first position at or after `pos` where a textual number may
+     *        start in `text`.
+     *
+     * That is the start of the first alpha token that is one of the keywords that
+     * start the grammar in any of its variants (see grammar_starts_number()), e.g.
+     * 'zero', 'a', and the words of Digit, Teens and SecDig. No textual number starts before it, so the text from
+     * `pos` up to it is converted as is, without tokenizing nor matching it.
+     *
+     * The alpha tokens are found block by block by the vectorized classification
+     * kernels (see token_scanner_t), and most of them are then rejected by their
+     * first letter, so only a few are looked up in the lexicon.
+     *
+     * @param text Text to scan.
+     * @param pos Position from which a textual number is searched, which must be
+     *  the start of a token.
+     * @returns The start of the keyword, or `text.size()` if there is none.
+     */
+    std::size_t find_number_start(absl::string_view text, std::size_t pos) noexcept;
+
+}
+
+#endif // INCLUDE_GUARD__SPLIT_H__GUID_7e4b1f0c2a9d4c5e8f36d0a1b9e2c847
@@ -0,0 +1,88 @@
+#ifndef INCLUDE_GUARD__SPSC_QUEUE_H__GUID_4a8e2c61d0b94f7a9e35c1f08b6d27e3
+#define INCLUDE_GUARD__SPSC_QUEUE_H__GUID_4a8e2c61d0b94f7a9e35c1f08b6d27e3
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace core {
+
+    /**
+     * @brief Bounded lock-free queue with a single producer and a single consumer.
+     *
+     * The producer thread calls push() and close(), the consumer thread calls pop().
+     * A full queue blocks the producer until the consumer makes room for the new
+     * element, which provides backpressure between pipeline stages.
+     *
+     * @note Blocking is implemented by yielding the thread, so it is only meant
+     *   for stages that are expected to be busy most of the time.
+     */
+    template<typename T>
+    class spsc_queue_t {
+    public:
+        /// Constructs a queue that holds up to `capacity` elements, at least one.
+        explicit spsc_queue_t(std::size_t capacity) noexcept :
+            slots_((capacity ? capacity : 1) + 1), head_(0), tail_(0), closed_(false)
+        {}
+
+        spsc_queue_t(const spsc_queue_t&) = delete;
+        spsc_queue_t& operator=(const spsc_queue_t&) = delete;
+
+        /// Maximum number of elements in the queue.
+        std::size_t capacity() const noexcept { return slots_.size() - 1; }
+
+        /// Appends `value`, waiting until there is room for it.
+        void push(T value) noexcept
+        {
+            auto tail = tail_.load(std::memory_order_relaxed);
+            auto next = advance(tail);
+            while (next == head_.load(std::memory_order_acquire))
+                std::this_thread::yield();
+
+            slots_[tail] = std::move(value);
+            tail_.store(next, std::memory_order_release);
+        }
+
+        /// Signals the consumer that no more elements will be pushed.
+        void close() noexcept
+        {
+            closed_.store(true, std::memory_order_release);
+        }
+
+        /**
+         * @brief Removes the first element into `value`, waiting until there is one.
+         *
+         * @returns false if the queue is empty and closed, true otherwise.
+         */
+        bool pop(T& value) noexcept
+        {
+            auto head = head_.load(std::memory_order_relaxed);
+            while (head == tail_.load(std::memory_order_acquire)) {
+                // the last elements may have been pushed right before closing
+                if (closed_.load(std::memory_order_acquire) && head == tail_.load(std::memory_order_acquire))
+                    return false;
+                std::this_thread::yield();
+            }
+
+            value = std::move(slots_[head]);
+            head_.store(advance(head), std::memory_order_release);
+            return true;
+        }
+
+    private:
+        std::size_t advance(std::size_t idx) const noexcept
+        {
+            return idx + 1 == slots_.size() ? 0 : idx + 1;
+        }
+
+        std::vector<T> slots_;              //!< Ring of capacity() + 1 slots, one is always empty.
+        alignas(64) std::atomic<std::size_t> head_;     //!< Next slot to pop, owned by the consumer.
+        alignas(64) std::atomic<std::size_t> tail_;     //!< Next slot to push, owned by the producer.
+        std::atomic<bool> closed_;          //!< Whether the producer has finished.
+    };
+
+}
+
+#endif // INCLUDE_GUARD__SPSC_QUEUE_H__GUID_4a8e2c61d0b94f7a9e35c1f08b6d27e3
@@ -0,0 +1,189 @@
+#ifndef INCLUDE_GUARD__STATS_H__GUID_e5c27a9f13b84d06a7f1c3d82b96e40f
+#define INCLUDE_GUARD__STATS_H__GUID_e5c27a9f13b84d06a7f1c3d82b96e40f
+
+#include "char_class.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <iosfwd>
+
+namespace core {
+
+    /// Rules of the cardinal numbers grammar, see match_cardinal_number().
+    enum class grammar_rule_e : std::uint8_t {
+        CardNum, AValue, Millions, MillionSfx, Thousands, ThousandSfx,
+        Hundreds, HundredSfx, Below100, SecDig, Teens, Digit,
+        count_      //!< Number of rules, not a rule.
+    };
+
+    /// Returns the name of `rule`, as written in the grammar.
+    const char* grammar_rule_name(grammar_rule_e rule) noexcept;
+
+    /// Stages of a conversion whose wall time is measured.
+    enum class stage_e : std::uint8_t {
+        read,       //!< Reading the input, only measured on its own by convert_pipelined().
+        tokenize,   //!< Splitting the text into tokens, includes reading in serial conversions.
+        match,      //!< Matching the grammar on already tokenized text.
+        write,      //!< Writing the output.
+        count_      //!< Number of stages, not a stage.
+    };
+
+    /// Returns the name of `stage`.
+    const char* stage_name(stage_e stage) noexcept;
+
+    class stats_t;
+
+    /**
+     * @brief Measures the wall time of a stage, from construction to destruction.
+     *
+     * See stats_t::time().
+     */
+    class stage_timer_t {
+    public:
+        stage_timer_t(stats_t& stats, stage_e stage) noexcept;
+        stage_timer_t(stage_timer_t&& other) noexcept;
+        ~stage_timer_t();
+
+        stage_timer_t(const stage_timer_t&) = delete;
+        stage_timer_t& operator=(const stage_timer_t&) = delete;
+
+    private:
+        stats_t* stats_;                                    //!< Stats to update, nullptr once moved from.
+        stage_e stage_;                                     //!< Measured stage.
+        std::chrono::steady_clock::time_point start_;       //!< Construction time.
+    };
+
+    /**
+     * @brief Counters of a conversion.
+     *
+     * The conversion functions and the grammar are templates on the type of the stats,
+     * either stats_t or null_stats_t, which has the same interface and does nothing,
+     * so collecting stats has no cost unless requested.
+     */
+    class stats_t {
+    public:
+        /// Whether the stats are actually collected.
+        static constexpr bool enabled = true;
+
+        /// Constructs stats with all the counters set to zero.
+        stats_t() noexcept;
+
+        /// Counts a converted token of `category` and `bytes` characters.
+        void count_token(token_category_e category, std::size_t bytes) noexcept
+        {
+            bytes_ += bytes;
+            ++tokens_[static_cast<std::size_t>(category)];
+        }
+
+        /// Counts `bytes` characters that were written without being tokenized, see find_number_start().
+        void count_skipped(std::size_t bytes) noexcept
+        {
+            bytes_ += bytes;
+            skipped_ += bytes;
+        }
+
+        /// Counts an attempt to match a textual number, which matched `size` tokens.
+        void count_match(std::uint64_t size) noexcept
+        {
+            ++match_attempts_;
+            if (size) {
+                ++matches_;
+                matched_tokens_ += size;
+            }
+        }
+
+        /// Counts a token examined by `rule` while matching the grammar.
+        void examine(grammar_rule_e rule) noexcept
+        {
+            ++examined_[static_cast<std::size_t>(rule)];
+        }
+
+        /// Returns a timer that adds its lifetime to the wall time of `stage`.
+        stage_timer_t time(stage_e stage) noexcept { return { *this, stage }; }
+
+        /// Adds `seconds` to the wall time of `stage`.
+        void add_time(stage_e stage, double seconds) noexcept
+        {
+            seconds_[static_cast<std::size_t>(stage)] += seconds;
+        }
+
+        /// Adds the counters of `other`, e.g. to combine the stats of several threads.
+        void merge(const stats_t& other) noexcept;
+
+        /// Number of characters converted.
+        std::uint64_t bytes() const noexcept { return bytes_; }
+
+        /// Number of characters written without being tokenized, which are included in bytes().
+        std::uint64_t skipped() const noexcept { return skipped_; }
+
+        /// Number of tokens of `category` converted.
+        std::uint64_t tokens(token_category_e category) const noexcept { return tokens_[static_cast<std::size_t>(category)]; }
+
+        /// Number of attempts to match a textual number.
+        std::uint64_t match_attempts() const noexcept { return match_attempts_; }
+
+        /// Number of textual numbers matched.
+        std::uint64_t matches() const noexcept { return matches_; }
+
+        /// Number of tokens that are part of a textual number.
+        std::uint64_t matched_tokens() const noexcept { return matched_tokens_; }
+
+        /// Number of tokens examined by `rule`, a token may be examined several times.
+        std::uint64_t examined(grammar_rule_e rule) const noexcept { return examined_[static_cast<std::size_t>(rule)]; }
+
+        /// Number of tokens examined by all the rules.
+        std::uint64_t examined() const noexcept;
+
+        /// Wall time of `stage` in seconds.
+        double seconds(stage_e stage) const noexcept { return seconds_[static_cast<std::size_t>(stage)]; }
+
+    private:
+        static constexpr std::size_t category_count = static_cast<std::size_t>(token_category_e::end);
+        static constexpr std::size_t rule_count = static_cast<std::size_t>(grammar_rule_e::count_);
+        static constexpr std::size_t stage_count = static_cast<std::size_t>(stage_e::count_);
+
+        std::uint64_t bytes_;                       //!< See bytes().
+        std::uint64_t skipped_;                     //!< See skipped().
+        std::uint64_t tokens_[category_count];      //!< See tokens().
+        std::uint64_t match_attempts_;              //!< See match_attempts().
+        std::uint64_t matches_;                     //!< See matches().
+        std::uint64_t matched_tokens_;              //!< See matched_tokens().
+        std::uint64_t examined_[rule_count];        //!< See examined().
+        double seconds_[stage_count];               //!< See seconds().
+    };
+
+    /// Timer that measures nothing, see null_stats_t.
+    struct null_timer_t {
+        null_timer_t() noexcept {}
+        ~null_timer_t() {}
+    };
+
+    /**
+     * @brief Stats that are not collected.
+     *
+     * Has the same interface as stats_t, but every function is empty, so the
+     * compiler removes any trace of them.
+     */
+    struct null_stats_t {
+        static constexpr bool enabled = false;
+
+        void count_token(token_category_e, std::size_t) noexcept {}
+        void count_skipped(std::size_t) noexcept {}
+        void count_match(std::uint64_t) noexcept {}
+        void examine(grammar_rule_e) noexcept {}
+        null_timer_t time(stage_e) noexcept { return {}; }
+        void add_time(stage_e, double) noexcept {}
+    };
+
+    /**
+     * @brief Prints `stats` in a human readable format.
+     *
+     * Examined tokens that are not part of any match are wasted work of the lookahead
+     * of the grammar.
+     */
+    void print_stats(const stats_t& stats, std::ostream& os) noexcept;
+
+}
+
+#endif // INCLUDE_GUARD__STATS_H__GUID_e5c27a9f13b84d06a7f1c3d82b96e40f
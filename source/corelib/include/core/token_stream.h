@@ -1,6 +1,12 @@
 #ifndef INCLUDE_GUARD__TOKEN_STREAM_H__GUID_58400c2d0a5b481c8ecbf531a1ab968b
 #define INCLUDE_GUARD__TOKEN_STREAM_H__GUID_58400c2d0a5b481c8ecbf531a1ab968b
 
+#include "arena.h"
+#include "char_class.h"
+#include "keyword.h"
+
+#include "absl/strings/string_view.h"
+
 #include <iosfwd>
 #include <vector>
 #include <string>
@@ -9,22 +15,29 @@
 
 namespace core {
 
-    /**
-     * @brief The type of a token.
-     */
-    enum class token_category_e {
-        space,      //!< Token is formed by whitespace characters.
-        alpha,      //!< Token is formed by letters.
-        other,      //!< Token is punctuation, control characters, etc.
-        end         //!< Sentinel token
-    };
-
     class token_view_t;
     class forward_token_iterator_t;
     class input_token_iterator_t;
 
     struct eof_token_t {};
 
+    /**
+     * @brief Compact record of a token, with all the grammar needs to know about it.
+     *
+     * The records of the stored tokens are kept contiguous, see
+     * forward_token_iterator_t::records(), so that the grammar indexes
+     * a plain array instead of going through the token stream.
+     */
+    struct token_record_t {
+        token_category_e category;  //!< Category of the token.
+        keyword_e keyword;          //!< Keyword of the token, resolved from its actual text.
+
+        /// True if the token is end of tokens.
+        bool is_end() const noexcept { return category == token_category_e::end; }
+        /// True if the token category is space.
+        bool is_space() const noexcept { return category == token_category_e::space; }
+    };
+
     /**
      * @brief This class encapsulates the abstract notion of a token stream from an istream.
      *
@@ -46,18 +59,40 @@ namespace core {
     * where each | separates a token, and the categories are alpha (a), space (s), other (o)
     * and end of stream (e).
     *
-    * The token stream is lazily constructed from an istream and can be accessed
-    * by the forward_token_iterator_t and input_token_iterator_t helpers.
+    * The token stream is lazily constructed from an istream, or from an in-memory
+    * buffer, and can be accessed by the forward_token_iterator_t and
+    * input_token_iterator_t helpers. Tokens are views into the buffer, or into the
+    * last block read from the istream. Only the tokens that are still stored when
+    * the block is refilled, and those that span several blocks, are copied into an
+    * arena, which is reset as soon as none of them is stored. Keywords are resolved
+    * from the raw text of the tokens, ignoring case, so their text is never normalized.
     *
     * @note In order to support forward_token_iterator_t, this class stores the tokens
     *   in a transient storage. Once a token is consumed by incrementing a input_token_iterator_t,
     *   it can no longer be accessed by any iterator.
+    *
+    * @note The transient storage is a circular buffer whose capacity is given on construction,
+    *   which should be the maximum look ahead needed by the consumer of the stream (e.g.
+    *   see max_lookahead for the grammar). The storage of consumed tokens is reused, and
+    *   so are the blocks of the arena, so no allocations happen in steady state. Looking
+    *   further ahead is allowed, but doubles the capacity of the buffer.
+    *
+    * @note The records of the tokens (see token_record_t) are kept apart from their text,
+    *   in a circular buffer that is mirrored: the record of token `id` is written both
+    *   at `id & mask_` and at the same position after the capacity. Therefore, the
+    *   records of any stored tokens are contiguous, starting at the first of them.
     */
     class token_stream_t {
         friend class token_view_t;
         friend class forward_token_iterator_t;
         friend class input_token_iterator_t;
     public:
+        /// Default number of tokens that can be stored without growing the storage.
+        static constexpr std::size_t default_window = 16;
+
+        /// Number of characters read at once from an istream.
+        static constexpr std::size_t block_size = 64 * 1024;
+
         /**
          * Constructs a token_stream_t from an istream.
          *
@@ -65,8 +100,35 @@ namespace core {
          * contained within the lifetime of its referred istream.
          * Modifying the istream once a token_stream_t is constructed
          * will produce uncontrolled side-effects on the token stream.
+         *
+         * @param is Stream to be tokenized.
+         * @param window Number of tokens that can be looked ahead without growing the storage.
          */
-        token_stream_t(std::istream& is) noexcept;
+        token_stream_t(std::istream& is, std::size_t window = default_window) noexcept;
+
+        /**
+         * Constructs a token_stream_t from an in-memory buffer.
+         *
+         * The lifetime of an object of token_stream_t must be
+         * contained within the lifetime of the referred buffer, as
+         * tokens are views into it.
+         *
+         * @param buffer Text to be tokenized.
+         * @param window Number of tokens that can be looked ahead without growing the storage.
+         */
+        explicit token_stream_t(absl::string_view buffer, std::size_t window = default_window) noexcept;
+
+        /**
+         * @brief Restarts the token stream on another in-memory buffer.
+         *
+         * The storage of the tokens is kept, so tokenizing many short buffers
+         * with the same token_stream_t does not allocate in steady state.
+         * Iterators to the previous tokens are invalidated.
+         *
+         * @param buffer Text to be tokenized, with the same lifetime requirements
+         *   as the buffer of the constructor.
+         */
+        void reset(absl::string_view buffer) noexcept;
 
         /**
          * Check whether the token stream is empty, i.e. all tokens
@@ -94,23 +156,32 @@ namespace core {
         eof_token_t end() const noexcept;
 
     private:
-        /// Access to the normalized text of the stored token `id`.
-        std::string& token(std::size_t id) noexcept;
+        /// Text of an active token, its record is stored apart in records_.
+        struct token_t {
+            absl::string_view raw;          //!< Actual text of the token.
+            bool stored;                    //!< Whether raw is a view into arena_ rather than into buffer_.
+        };
+
+        /// Slot of the circular buffer where the text of token `id` is stored.
+        token_t& slot(std::size_t id) noexcept { return window_[id & mask_]; }
 
-        /// Const access to the normalized text of the stored token `id`.
-        const std::string& token(std::size_t id) const noexcept;
+        /// Const slot of the circular buffer where the text of token `id` is stored.
+        const token_t& slot(std::size_t id) const noexcept { return window_[id & mask_]; }
 
-        /// Access to the actual text of the stored token `id`.
-        std::string& token_raw(std::size_t id) noexcept;
+        /// Record of the stored token `id`.
+        const token_record_t& record(std::size_t id) const noexcept { return records_[id & mask_]; }
 
-        /// Const access to the actual text of the stored token `id`.
-        const std::string& token_raw(std::size_t id) const noexcept;
+        /// Writes the record of token `id` at both of its positions in records_.
+        void set_record(std::size_t id, token_record_t record) noexcept;
 
-        /// Access to the category of stored token `id`.
-        token_category_e& token_category(std::size_t id) noexcept;
+        /// Actual text of the stored token `id`.
+        absl::string_view token_raw(std::size_t id) const noexcept;
 
-        /// Const access to the category of stored token `id`.
-        const token_category_e& token_category(std::size_t id) const noexcept;
+        /// Keyword of the stored token `id`.
+        keyword_e token_keyword(std::size_t id) const noexcept;
+
+        /// Category of the stored token `id`.
+        token_category_e token_category(std::size_t id) const noexcept;
 
         /// Checks whether a token is being stored.
         bool token_in_window(std::size_t) const noexcept;
@@ -118,20 +189,43 @@ namespace core {
         /// Returns last token ID that is stored.
         std::size_t last() noexcept;
 
+        /// Reserves the slot for a new token, reusing its storage, and returns it.
+        token_t& push_token() noexcept;
+
+        /// Doubles the capacity of the circular buffer, keeping the stored tokens.
+        void grow_window() noexcept;
+
+        /// Reads the next block of the associated stream into buffer_, returns false on EOF.
+        bool fill_buffer() noexcept;
+
+        /// Copies the text of the stored tokens that are views into buffer_ to arena_.
+        void store_tokens() noexcept;
+
         /// Consumes a new token from the associated stream and stores it.
         void get_token() noexcept;
 
         /// Consumes tokens from the associated stream until `id` token has been stored or EOF is reached.
         std::size_t get_token(std::size_t id) noexcept;
 
+        /// Consumes tokens until `count` tokens from `id` are stored, and returns their contiguous records.
+        const token_record_t* get_records(std::size_t id, std::size_t count) noexcept;
+
         /// Consumes removing all tokens from storage up to `id`.
         std::size_t get_remove_token(std::size_t id) noexcept;
 
-        std::istream* is_;                              //!< Associated text stream.
-        std::size_t first_;                             //!< First active token ID.
-        std::vector<std::string> tokens_;               //!< Raw text of the active tokens.
-        std::vector<std::string> normalized_tokens_;    //!< Normalized text of the active tokens.
-        std::vector<token_category_e> token_type_;      //!< Category of the active tokens.
+        std::istream* is_;              //!< Associated text stream, null when reading from an in-memory buffer.
+        std::vector<char> block_;       //!< Last block read from is_.
+        absl::string_view buffer_;      //!< Text being tokenized, either the in-memory buffer or the valid part of block_.
+        std::size_t offset_;            //!< Read position within buffer_.
+        std::size_t carry_;             //!< Size of the incomplete character that follows buffer_ in block_.
+        token_scanner_t scanner_;       //!< Finds the token boundaries of buffer_.
+        arena_t arena_;                 //!< Text of the tokens that outlive the block they were read from.
+        std::size_t stored_;            //!< Number of active tokens whose text is in arena_.
+        std::size_t first_;             //!< First active token ID.
+        std::size_t size_;              //!< Number of active tokens.
+        std::size_t mask_;              //!< Capacity of window_ minus one, the capacity is a power of two.
+        std::vector<token_t> window_;   //!< Circular buffer of tokens, token `id` is stored at `id & mask_`.
+        std::vector<token_record_t> records_; //!< Mirrored circular buffer of records, twice the capacity of window_.
     };
 
     class token_view_t {
@@ -139,7 +233,7 @@ namespace core {
         friend class input_token_iterator_t;
     public:
         /// The token category.
-        token_category_e category() const noexcept { return static_cast<const token_stream_t*>(stream_)->token_category(id_); };
+        token_category_e category() const noexcept { return stream_->token_category(id_); };
         /// True if the token is end of tokens.
         bool is_end() const noexcept { return category() == token_category_e::end; }
         /// True if the token category is space.
@@ -148,10 +242,10 @@ namespace core {
         bool is_alpha() const noexcept { return category() == token_category_e::alpha; }
         /// True if the token category is other.
         bool is_other() const noexcept { return category() == token_category_e::other; }
-        /// The normalized textual representation of the token.
-        const std::string& str() const noexcept { return static_cast<const token_stream_t*>(stream_)->token(id_); };
+        /// The keyword of the grammar the token represents, if any.
+        keyword_e keyword() const noexcept { return stream_->token_keyword(id_); };
         /// The original textual representation of the token.
-        const std::string& raw_str() const noexcept { return static_cast<const token_stream_t*>(stream_)->token_raw(id_); };
+        absl::string_view raw_str() const noexcept { return static_cast<const token_stream_t*>(stream_)->token_raw(id_); };
         /// The sequential ID of the token.
         std::size_t id() const noexcept { return id_; }
 
@@ -223,6 +317,18 @@ namespace core {
          */
         friend forward_token_iterator_t operator+(std::size_t incr, forward_token_iterator_t it) noexcept { it += incr; return it; }
 
+        /**
+         * @brief Returns the contiguous records of the current token and the following ones.
+         *
+         * The first `count` records can be indexed, unless the stream ends before, in which
+         * case the records can be indexed up to the end token.
+         *
+         * @param count Number of tokens to look ahead, including the current one, at least 1.
+         * @note This may trigger that token_stream_t consumes from its istream.
+         * @note The records are invalidated as soon as any iterator of the stream is incremented.
+         */
+        const token_record_t* records(std::size_t count) const noexcept { return stream_->get_records(id_, count); }
+
         /// Heterogeneous comparison, returns whether self represents end of tokens.
         friend bool operator==(const forward_token_iterator_t& self, const eof_token_t&) noexcept { return self.is_end(); }
 
@@ -0,0 +1,86 @@
+#include "core/arena.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace core {
+
+    constexpr std::size_t arena_t::default_block_size;
+
+    arena_t::arena_t(std::size_t block_size) noexcept :
+        block_size_(std::max<std::size_t>(block_size, 1)), current_(0), used_(0)
+    {}
+
+    absl::string_view arena_t::store(absl::string_view text) noexcept
+    {
+        if (text.empty()) return {};
+        auto p = allocate(text.size());
+        std::memcpy(p, text.data(), text.size());
+        return { p, text.size() };
+    }
+
+    absl::string_view arena_t::append(absl::string_view last, absl::string_view text) noexcept
+    {
+        if (last.empty()) return store(text);
+        if (text.empty()) return last;
+
+        // the last text can grow in place if nothing follows it in its block
+        auto& block = blocks_[current_];
+        assert(last.data() + last.size() == block.data.get() + used_);
+        if (block.size - used_ >= text.size()) {
+            std::memcpy(block.data.get() + used_, text.data(), text.size());
+            used_ += text.size();
+            return { last.data(), last.size() + text.size() };
+        }
+
+        // otherwise it is moved to a block with room for twice its size, so that
+        // growing it is amortized
+        auto size = last.size() + text.size();
+        auto p = allocate(2 * size);
+        used_ -= size;
+        std::memcpy(p, last.data(), last.size());
+        std::memcpy(p + last.size(), text.data(), text.size());
+        return { p, size };
+    }
+
+    void arena_t::reset() noexcept
+    {
+        current_ = 0;
+        used_ = 0;
+    }
+
+    std::size_t arena_t::capacity() const noexcept
+    {
+        std::size_t size = 0;
+        for (auto& block : blocks_) size += block.size;
+        return size;
+    }
+
+    char* arena_t::allocate(std::size_t size) noexcept
+    {
+        if (current_ != blocks_.size() && blocks_[current_].size - used_ >= size) {
+            auto p = blocks_[current_].data.get() + used_;
+            used_ += size;
+            return p;
+        }
+
+        // move to the first unused block that can hold the text, the ones that are
+        // too small are kept after it for smaller texts, or to a new block
+        auto first = used_ == 0 ? current_ : current_ + 1;
+        auto next = first;
+        while (next != blocks_.size() && blocks_[next].size < size) ++next;
+        if (next == blocks_.size()) {
+            auto block_size = std::max(block_size_, size);
+            blocks_.push_back({ std::unique_ptr<char[]>(new char[block_size]), block_size });
+        }
+        std::rotate(blocks_.begin() + static_cast<std::ptrdiff_t>(first),
+                    blocks_.begin() + static_cast<std::ptrdiff_t>(next),
+                    blocks_.begin() + static_cast<std::ptrdiff_t>(next + 1));
+
+        current_ = first;
+        used_ = size;
+        return blocks_[current_].data.get();
+    }
+
+}
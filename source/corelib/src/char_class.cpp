@@ -0,0 +1,483 @@
+#include "core/char_class.h"
+
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define W2D_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+namespace {
+    using namespace core;
+
+    /// Index of the least significant bit set of a non-zero mask.
+    unsigned count_trailing_zeros(std::uint64_t m) noexcept
+    {
+        assert(m != 0);
+#if defined(_MSC_VER)
+        unsigned long idx;
+        _BitScanForward64(&idx, m);
+        return idx;
+#else
+        return static_cast<unsigned>(__builtin_ctzll(m));
+#endif
+    }
+
+    /// Category of each of the 256 characters.
+    struct char_table_t {
+        token_category_e category[256];
+
+        char_table_t() noexcept {
+            for (int i = 0; i < 256; ++i) {
+                auto c = static_cast<unsigned char>(i);
+                if (c == ' ' || (c >= '\t' && c <= '\r'))                  category[i] = token_category_e::space;
+                else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) category[i] = token_category_e::alpha;
+                else                                                        category[i] = token_category_e::other;
+            }
+        }
+    };
+
+    const char_table_t char_table;
+
+    /// Decoding of the UTF-8 sequences by their lead byte.
+    struct utf8_table_t {
+        std::uint8_t size[256]; //!< Size of the sequence, 0 if the byte cannot start one.
+        std::uint8_t lo[256];   //!< Smallest valid second byte of the sequence.
+        std::uint8_t hi[256];   //!< Largest valid second byte of the sequence.
+
+        utf8_table_t() noexcept {
+            for (int i = 0; i < 256; ++i) {
+                // overlong encodings, surrogates and code points past U+10FFFF are
+                // rejected by the range of the second byte
+                size[i] = i < 0x80 ? 1 : i < 0xc2 ? 0 : i < 0xe0 ? 2 : i < 0xf0 ? 3 : i < 0xf5 ? 4 : 0;
+                lo[i] = i == 0xe0 ? 0xa0 : i == 0xf0 ? 0x90 : 0x80;
+                hi[i] = i == 0xed ? 0x9f : i == 0xf4 ? 0x8f : 0xbf;
+            }
+        }
+    };
+
+    const utf8_table_t utf8_table;
+
+    /// Returns whether `c` is a continuation byte of a UTF-8 sequence.
+    bool is_continuation(unsigned char c) noexcept
+    {
+        return (c & 0xc0) == 0x80;
+    }
+
+    /// Decodes the UTF-8 character at `p`, returns its size or 0 if it is not well-formed.
+    std::size_t decode(const unsigned char* p, const unsigned char* last, std::uint32_t& cp) noexcept
+    {
+        std::size_t size = utf8_table.size[*p];
+        if (size == 1) {
+            cp = *p;
+            return 1;
+        }
+        if (size == 0 || static_cast<std::size_t>(last - p) < size ||
+            p[1] < utf8_table.lo[*p] || p[1] > utf8_table.hi[*p])
+            return 0;
+
+        cp = (*p & (0x7fu >> size)) << 6 | (p[1] & 0x3fu);
+        for (std::size_t i = 2; i < size; ++i) {
+            if (!is_continuation(p[i])) return 0;
+            cp = cp << 6 | (p[i] & 0x3fu);
+        }
+        return size;
+    }
+
+    /// Code points [first, last].
+    struct code_point_range_t {
+        std::uint32_t first;
+        std::uint32_t last;
+    };
+
+    /// Unicode whitespace that is not ASCII.
+    const code_point_range_t unicode_space[] = {
+        { 0x0085, 0x0085 }, { 0x00a0, 0x00a0 }, { 0x1680, 0x1680 }, { 0x2000, 0x200a },
+        { 0x2028, 0x2029 }, { 0x202f, 0x202f }, { 0x205f, 0x205f }, { 0x3000, 0x3000 },
+    };
+
+    /// Letters and combining marks of the main scripts that are not ASCII, sorted.
+    const code_point_range_t unicode_alpha[] = {
+        // Latin-1, Latin Extended, IPA, modifier letters and combining diacritics
+        { 0x00aa, 0x00aa }, { 0x00b5, 0x00b5 }, { 0x00ba, 0x00ba }, { 0x00c0, 0x00d6 },
+        { 0x00d8, 0x00f6 }, { 0x00f8, 0x02c1 }, { 0x02c6, 0x02d1 }, { 0x02e0, 0x02e4 },
+        { 0x02ec, 0x02ec }, { 0x02ee, 0x02ee },
+        // Greek, Cyrillic, Armenian
+        { 0x0300, 0x0374 }, { 0x0376, 0x0377 }, { 0x037a, 0x037d }, { 0x037f, 0x037f },
+        { 0x0386, 0x0386 }, { 0x0388, 0x038a }, { 0x038c, 0x038c }, { 0x038e, 0x03a1 },
+        { 0x03a3, 0x03f5 }, { 0x03f7, 0x0481 }, { 0x0483, 0x052f }, { 0x0531, 0x0556 },
+        { 0x0559, 0x0559 }, { 0x0560, 0x0588 },
+        // Hebrew, Arabic, Syriac, Thaana, N'Ko
+        { 0x0591, 0x05bd }, { 0x05bf, 0x05bf }, { 0x05c1, 0x05c2 }, { 0x05c4, 0x05c5 },
+        { 0x05c7, 0x05c7 }, { 0x05d0, 0x05ea }, { 0x05ef, 0x05f2 }, { 0x0610, 0x061a },
+        { 0x0620, 0x065f }, { 0x066e, 0x06d3 }, { 0x06d5, 0x06dc }, { 0x06df, 0x06e8 },
+        { 0x06ea, 0x06ef }, { 0x06fa, 0x06fc }, { 0x06ff, 0x06ff }, { 0x0710, 0x074a },
+        { 0x074d, 0x07b1 }, { 0x07ca, 0x07f5 },
+        // Indic scripts, without their digits and punctuation
+        { 0x0900, 0x0963 }, { 0x0971, 0x09e3 }, { 0x09f0, 0x09f1 }, { 0x0a00, 0x0a63 },
+        { 0x0a70, 0x0a75 }, { 0x0a80, 0x0ae3 }, { 0x0b00, 0x0b63 }, { 0x0b71, 0x0b71 },
+        { 0x0b80, 0x0be3 }, { 0x0c00, 0x0c63 }, { 0x0c80, 0x0ce3 }, { 0x0d00, 0x0d63 },
+        { 0x0d7a, 0x0ddf },
+        // Thai, Lao, Myanmar, Georgian, Hangul Jamo, Ethiopic, Cherokee, Canadian
+        // syllabics, Ogham, Runic, Khmer
+        { 0x0e01, 0x0e3a }, { 0x0e40, 0x0e4e }, { 0x0e81, 0x0ece }, { 0x1000, 0x103f },
+        { 0x10a0, 0x10ff }, { 0x1100, 0x135f }, { 0x13a0, 0x13f5 }, { 0x1401, 0x166c },
+        { 0x1681, 0x169a }, { 0x16a0, 0x16ea }, { 0x1780, 0x17d3 },
+        // Latin Extended Additional, Greek Extended, Glagolitic, Coptic, Tifinagh
+        { 0x1e00, 0x1ffc }, { 0x2c00, 0x2ce4 }, { 0x2d00, 0x2d2d }, { 0x2d30, 0x2d67 },
+        { 0x2de0, 0x2dff },
+        // CJK, kana, bopomofo, hangul, Yi
+        { 0x3005, 0x3006 }, { 0x3031, 0x3035 }, { 0x303b, 0x303c }, { 0x3041, 0x3096 },
+        { 0x3099, 0x309a }, { 0x309d, 0x309f }, { 0x30a1, 0x30fa }, { 0x30fc, 0x30ff },
+        { 0x3105, 0x312f }, { 0x3131, 0x318e }, { 0x31a0, 0x31bf }, { 0x31f0, 0x31ff },
+        { 0x3400, 0x4dbf }, { 0x4e00, 0x9fff }, { 0xa000, 0xa48c }, { 0xa640, 0xa69f },
+        { 0xa722, 0xa7ff }, { 0xac00, 0xd7a3 }, { 0xd7b0, 0xd7fb }, { 0xf900, 0xfaff },
+        // presentation forms, fullwidth and halfwidth forms
+        { 0xfb00, 0xfb06 }, { 0xfb13, 0xfb17 }, { 0xfb1d, 0xfb4f }, { 0xfb50, 0xfd3d },
+        { 0xfd50, 0xfdfb }, { 0xfe70, 0xfefc }, { 0xff21, 0xff3a }, { 0xff41, 0xff5a },
+        { 0xff66, 0xffdc },
+        // CJK supplementary planes
+        { 0x20000, 0x2fa1f }, { 0x30000, 0x3134f },
+    };
+
+    /// Returns whether `cp` is within one of the sorted `ranges`.
+    template <std::size_t N>
+    bool in_ranges(const code_point_range_t (&ranges)[N], std::uint32_t cp) noexcept
+    {
+        auto it = std::lower_bound(ranges, ranges + N, cp,
+            [](const code_point_range_t& r, std::uint32_t c) { return r.last < c; });
+        return it != ranges + N && it->first <= cp;
+    }
+
+    /// Category of a code point, looked up in the ranges.
+    token_category_e classify_range(std::uint32_t cp) noexcept
+    {
+        if (in_ranges(unicode_space, cp)) return token_category_e::space;
+        if (in_ranges(unicode_alpha, cp)) return token_category_e::alpha;
+        return token_category_e::other;
+    }
+
+    /// Category of the code points of up to two bytes, which cover most alphabetic scripts.
+    struct short_table_t {
+        static constexpr std::uint32_t size = 0x800;
+        token_category_e category[size];
+
+        short_table_t() noexcept {
+            for (std::uint32_t cp = 0; cp < size; ++cp)
+                category[cp] = cp < 0x80 ? char_table.category[cp] : classify_range(cp);
+        }
+    };
+
+    const short_table_t short_table;
+
+    /// Category of a code point.
+    token_category_e classify_code_point(std::uint32_t cp) noexcept
+    {
+        return cp < short_table_t::size ? short_table.category[cp] : classify_range(cp);
+    }
+
+    char_class_masks_t classify_scalar(const char* p) noexcept
+    {
+        char_class_masks_t masks = { 0, 0, 0 };
+        for (std::size_t i = 0; i < char_class_block; ++i) {
+            auto c = static_cast<unsigned char>(p[i]);
+            auto t = char_table.category[c];
+            masks.space |= std::uint64_t(t == token_category_e::space) << i;
+            masks.alpha |= std::uint64_t(t == token_category_e::alpha) << i;
+            masks.non_ascii |= std::uint64_t(c >> 7) << i;
+        }
+        return masks;
+    }
+
+#if defined(W2D_X86_KERNELS)
+
+    // All the kernels use the same trick: a character c is within [lo, lo + n] iff the
+    // unsigned difference c - lo is not greater than n. Lowercase and uppercase letters
+    // only differ in the 0x20 bit, so setting it allows a single range check for alpha.
+
+    __attribute__((target("sse2")))
+    char_class_masks_t classify_sse2(const char* p) noexcept
+    {
+        const __m128i blank = _mm_set1_epi8(' ');
+        const __m128i tab = _mm_set1_epi8('\t');
+        const __m128i tab_span = _mm_set1_epi8('\r' - '\t');
+        const __m128i lower = _mm_set1_epi8(0x20);
+        const __m128i a = _mm_set1_epi8('a');
+        const __m128i alpha_span = _mm_set1_epi8('z' - 'a');
+
+        char_class_masks_t masks = { 0, 0, 0 };
+        for (std::size_t i = 0; i < char_class_block; i += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            __m128i d = _mm_sub_epi8(v, tab);
+            __m128i space = _mm_or_si128(_mm_cmpeq_epi8(v, blank), _mm_cmpeq_epi8(_mm_min_epu8(d, tab_span), d));
+            __m128i l = _mm_sub_epi8(_mm_or_si128(v, lower), a);
+            __m128i alpha = _mm_cmpeq_epi8(_mm_min_epu8(l, alpha_span), l);
+            masks.space |= std::uint64_t(static_cast<std::uint16_t>(_mm_movemask_epi8(space))) << i;
+            masks.alpha |= std::uint64_t(static_cast<std::uint16_t>(_mm_movemask_epi8(alpha))) << i;
+            masks.non_ascii |= std::uint64_t(static_cast<std::uint16_t>(_mm_movemask_epi8(v))) << i;
+        }
+        return masks;
+    }
+
+    __attribute__((target("avx2")))
+    char_class_masks_t classify_avx2(const char* p) noexcept
+    {
+        const __m256i blank = _mm256_set1_epi8(' ');
+        const __m256i tab = _mm256_set1_epi8('\t');
+        const __m256i tab_span = _mm256_set1_epi8('\r' - '\t');
+        const __m256i lower = _mm256_set1_epi8(0x20);
+        const __m256i a = _mm256_set1_epi8('a');
+        const __m256i alpha_span = _mm256_set1_epi8('z' - 'a');
+
+        char_class_masks_t masks = { 0, 0, 0 };
+        for (std::size_t i = 0; i < char_class_block; i += 32) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+            __m256i d = _mm256_sub_epi8(v, tab);
+            __m256i space = _mm256_or_si256(_mm256_cmpeq_epi8(v, blank), _mm256_cmpeq_epi8(_mm256_min_epu8(d, tab_span), d));
+            __m256i l = _mm256_sub_epi8(_mm256_or_si256(v, lower), a);
+            __m256i alpha = _mm256_cmpeq_epi8(_mm256_min_epu8(l, alpha_span), l);
+            masks.space |= std::uint64_t(static_cast<std::uint32_t>(_mm256_movemask_epi8(space))) << i;
+            masks.alpha |= std::uint64_t(static_cast<std::uint32_t>(_mm256_movemask_epi8(alpha))) << i;
+            masks.non_ascii |= std::uint64_t(static_cast<std::uint32_t>(_mm256_movemask_epi8(v))) << i;
+        }
+        return masks;
+    }
+
+    __attribute__((target("avx512f,avx512bw")))
+    char_class_masks_t classify_avx512(const char* p) noexcept
+    {
+        __m512i v = _mm512_loadu_si512(p);
+        __mmask64 space = _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(' ')) |
+                          _mm512_cmple_epu8_mask(_mm512_sub_epi8(v, _mm512_set1_epi8('\t')), _mm512_set1_epi8('\r' - '\t'));
+        __m512i l = _mm512_sub_epi8(_mm512_or_si512(v, _mm512_set1_epi8(0x20)), _mm512_set1_epi8('a'));
+        __mmask64 alpha = _mm512_cmple_epu8_mask(l, _mm512_set1_epi8('z' - 'a'));
+        return { space, alpha, _mm512_movepi8_mask(v) };
+    }
+
+#endif
+
+    using classify_fn = char_class_masks_t (*)(const char*);
+
+    classify_fn kernel(char_class_isa_e isa) noexcept
+    {
+        switch (isa) {
+#if defined(W2D_X86_KERNELS)
+        case char_class_isa_e::sse2:    return classify_sse2;
+        case char_class_isa_e::avx2:    return classify_avx2;
+        case char_class_isa_e::avx512:  return classify_avx512;
+#endif
+        default:                        return classify_scalar;
+        }
+    }
+
+    char_class_isa_e select_isa() noexcept
+    {
+#if defined(W2D_X86_KERNELS)
+        // this may be executed before the CPU model is initialized by the runtime
+        __builtin_cpu_init();
+#endif
+        if (char_class_isa_supported(char_class_isa_e::avx512)) return char_class_isa_e::avx512;
+        if (char_class_isa_supported(char_class_isa_e::avx2))   return char_class_isa_e::avx2;
+        if (char_class_isa_supported(char_class_isa_e::sse2))   return char_class_isa_e::sse2;
+        return char_class_isa_e::scalar;
+    }
+
+    const char_class_isa_e selected_isa = select_isa();
+    const classify_fn selected_kernel = kernel(selected_isa);
+}
+
+namespace core {
+
+    token_category_e classify_char(char c) noexcept
+    {
+        return char_table.category[static_cast<unsigned char>(c)];
+    }
+
+    std::size_t char_size(const char* p, const char* last) noexcept
+    {
+        std::uint32_t cp;
+        auto size = decode(reinterpret_cast<const unsigned char*>(p), reinterpret_cast<const unsigned char*>(last), cp);
+        return size ? size : 1;
+    }
+
+    token_category_e classify_char(const char* p, const char* last) noexcept
+    {
+        auto c = static_cast<unsigned char>(*p);
+        if (c < 0x80) return char_table.category[c];
+
+        std::uint32_t cp;
+        if (!decode(reinterpret_cast<const unsigned char*>(p), reinterpret_cast<const unsigned char*>(last), cp))
+            return token_category_e::other;
+        return classify_code_point(cp);
+    }
+
+    const char* char_begin(const char* first, const char* p, const char* last) noexcept
+    {
+        // a lead byte is at most three continuation bytes away, and the character
+        // is only well-formed if its sequence reaches `p`
+        auto q = p;
+        while (q != first && p - q < 3 && is_continuation(static_cast<unsigned char>(*q))) --q;
+        return q != p && char_size(q, last) > static_cast<std::size_t>(p - q) ? q : p;
+    }
+
+    const char* token_begin(const char* first, const char* last) noexcept
+    {
+        if (first == last) return last;
+
+        auto p = char_begin(first, last - 1, last);
+        auto t = classify_char(p, last);
+        while (p != first) {
+            auto q = char_begin(first, p - 1, last);
+            if (classify_char(q, last) != t) break;
+            p = q;
+        }
+        return p;
+    }
+
+    std::size_t incomplete_char_size(const char* first, const char* last) noexcept
+    {
+        // look for a lead byte that expects more continuation bytes than there are
+        auto q = last;
+        while (q != first && last - q < 3) {
+            auto c = static_cast<unsigned char>(*--q);
+            if (is_continuation(c)) continue;
+
+            auto n = static_cast<std::size_t>(last - q);
+            if (utf8_table.size[c] <= n) return 0;
+            if (n > 1) {
+                auto next = static_cast<unsigned char>(q[1]);
+                if (next < utf8_table.lo[c] || next > utf8_table.hi[c]) return 0;
+            }
+            return n;
+        }
+        return 0;
+    }
+
+    char_class_isa_e char_class_isa() noexcept
+    {
+        return selected_isa;
+    }
+
+    bool char_class_isa_supported(char_class_isa_e isa) noexcept
+    {
+        switch (isa) {
+        case char_class_isa_e::scalar:  return true;
+#if defined(W2D_X86_KERNELS)
+        case char_class_isa_e::sse2:    return __builtin_cpu_supports("sse2");
+        case char_class_isa_e::avx2:    return __builtin_cpu_supports("avx2");
+        case char_class_isa_e::avx512:  return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+        default:                        return false;
+        }
+    }
+
+    const char* char_class_isa_name(char_class_isa_e isa) noexcept
+    {
+        switch (isa) {
+        case char_class_isa_e::sse2:    return "sse2";
+        case char_class_isa_e::avx2:    return "avx2";
+        case char_class_isa_e::avx512:  return "avx512";
+        default:                        return "scalar";
+        }
+    }
+
+    char_class_masks_t classify_block(const char* p) noexcept
+    {
+        return selected_kernel(p);
+    }
+
+    char_class_masks_t classify_block(const char* p, char_class_isa_e isa) noexcept
+    {
+        return kernel(isa)(p);
+    }
+
+    const char* token_scanner_t::token_end(const char* first, const char* last) noexcept
+    {
+        assert(first < last);
+        if (!base_ || first < base_ || first >= base_ + char_class_block)
+            load(first, first, last);
+
+        // boundaries strictly after the start of the token
+        auto m = boundaries_ & (~std::uint64_t(1) << (first - base_));
+        while (!m) {
+            // the token continues up to the end of the block
+            auto next = base_ + char_class_block;
+            if (next >= last) return last;
+            load(next, first, last);
+            m = boundaries_;
+        }
+
+        auto end = base_ + count_trailing_zeros(m);
+        return end < last ? end : last;
+    }
+
+    const char* token_scanner_t::next_alpha_token(const char* first, const char* p, const char* last) noexcept
+    {
+        if (p >= last) return last;
+        if (!base_ || p < base_ || p >= base_ + char_class_block)
+            load(p, first, last);
+
+        auto m = alpha_starts_ & (~std::uint64_t(0) << (p - base_));
+        while (!m) {
+            auto next = base_ + char_class_block;
+            if (next >= last) return last;
+            load(next, first, last);
+            m = alpha_starts_;
+        }
+
+        auto start = base_ + count_trailing_zeros(m);
+        return start < last ? start : last;
+    }
+
+    void token_scanner_t::load(const char* base, const char* text_first, const char* last) noexcept
+    {
+        // the block cannot be read past the end of the text, copy it to a padded block
+        char_class_masks_t masks;
+        auto n = static_cast<std::size_t>(last - base);
+        if (n >= char_class_block) {
+            masks = classify_block(base);
+        }
+        else {
+            char padded[char_class_block] = {};
+            std::memcpy(padded, base, n);
+            masks = classify_block(padded);
+        }
+
+        // the bytes of multi-byte characters take the category of the whole character,
+        // which may start in the previous block or end in the next one
+        for (auto m = masks.non_ascii; m; ) {
+            auto i = count_trailing_zeros(m);
+            auto p = char_begin(text_first, base + i, last);
+            auto t = classify_char(p, last);
+            auto end = std::min(static_cast<std::size_t>(p + char_size(p, last) - base), char_class_block);
+            auto bits = ((std::uint64_t(1) << (end - i)) - 1) << i;
+            if (t == token_category_e::space) masks.space |= bits;
+            else if (t == token_category_e::alpha) masks.alpha |= bits;
+            m &= ~bits;
+        }
+
+        // compare the category of each character with the previous one, which for the
+        // first character of the block is the last one of the previous block
+        std::uint64_t prev_space = 0, prev_alpha = 0;
+        if (base != text_first) {
+            auto t = classify_char(char_begin(text_first, base - 1, last), last);
+            prev_space = t == token_category_e::space;
+            prev_alpha = t == token_category_e::alpha;
+        }
+        boundaries_ = (masks.space ^ ((masks.space << 1) | prev_space)) |
+                      (masks.alpha ^ ((masks.alpha << 1) | prev_alpha));
+        alpha_starts_ = masks.alpha & ~((masks.alpha << 1) | prev_alpha);
+
+        // the end of the text is always a boundary
+        if (n < char_class_block) boundaries_ |= std::uint64_t(1) << n;
+
+        base_ = base;
+    }
+
+}
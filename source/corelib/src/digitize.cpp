@@ -1,11 +1,22 @@
 #include "core/digitize.h"
 
+#include "core/char_class.h"
 #include "core/grammar.h"
+#include "core/output.h"
+#include "core/scheduler.h"
+#include "core/split.h"
+#include "core/spsc_queue.h"
 #include "core/token_stream.h"
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
-#include <locale>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
 
 namespace {
     using namespace core;
@@ -13,40 +24,630 @@ namespace {
     bool has_newline(const token_view_t& token) noexcept
     {
         if (!token.is_space()) return false;
-        const auto& str = token.raw_str();
+        auto str = token.raw_str();
         return std::find( str.begin(), str.end(), '\n') != str.end();
     }
+
+    /// Appends `text` to an output buffer.
+    void write_text(output_buffer_t& out, absl::string_view text) noexcept
+    {
+        out.write(text);
+    }
+
+    /// Appends `text` to a string.
+    void write_text(std::string& out, absl::string_view text) noexcept
+    {
+        out.append(text.data(), text.size());
+    }
+
+    /// Appends the digits of `n` to an output buffer.
+    void write_number(output_buffer_t& out, std::uint64_t n) noexcept
+    {
+        out.write(n);
+    }
+
+    /// Appends the digits of `n` to a string.
+    void write_number(std::string& out, std::uint64_t n) noexcept
+    {
+        char digits[max_uint_digits];
+        out.append(digits, format_uint(n, digits));
+    }
+
+    /// Output written over the text being converted, see convert_in_place().
+    struct in_place_out_t {
+        char* pos;  //!< Where the next output is written, never after the text still to be read.
+    };
+
+    /// Moves `text`, which is the text being converted or a literal, to the output.
+    void write_text(in_place_out_t& out, absl::string_view text) noexcept
+    {
+        if (text.data() != out.pos) std::memmove(out.pos, text.data(), text.size());
+        out.pos += text.size();
+    }
+
+    /// Writes the digits of `n` over the text of the textual number.
+    void write_number(in_place_out_t& out, std::uint64_t n) noexcept
+    {
+        out.pos += format_uint(n, out.pos);
+    }
+
+    /// Output of the edits of a conversion, see find_edits().
+    struct edit_out_t {
+        std::string* buffer;    //!< Encoded edits not written yet.
+        std::ostream* os;       //!< Where the buffer is written once large enough, or nullptr to keep it.
+        edit_format_e format;   //!< Encoding of the edits.
+        std::uint64_t pos;      //!< Offset in the whole text of the next token.
+    };
+
+    /// Skips `text`, which is not part of a textual number.
+    void write_text(edit_out_t& out, absl::string_view text) noexcept
+    {
+        out.pos += text.size();
+    }
+
+    /// Writes the digits of the textual number `m`, preceded by a newline if `newline`.
+    template<typename Out>
+    void write_match(Out& out, forward_token_iterator_t, const match_t& m, bool newline) noexcept
+    {
+        if (newline) write_text(out, "\n");
+        write_number(out, m.num);
+    }
+
+    /// Adds the edit of the textual number `m`, which starts at `first`.
+    void write_match(edit_out_t& out, forward_token_iterator_t first, const match_t& m, bool newline) noexcept
+    {
+        std::uint64_t length = 0;
+        for (auto i = 0u; i < m.size; ++i, ++first) length += first->raw_str().size();
+
+        append_edit(*out.buffer, edit_t{ out.pos, length, m.num, newline }, out.format);
+        out.pos += length;
+        if (out.os && out.buffer->size() >= output_buffer_t::default_block_size) {
+            out.os->write(out.buffer->data(), static_cast<std::streamsize>(out.buffer->size()));
+            out.buffer->clear();
+        }
+    }
+
+    /// Matches the grammar without collecting stats.
+    match_t match(forward_token_iterator_t it, null_stats_t&) noexcept
+    {
+        return match_cardinal_number(it);
+    }
+
+    /// Matches the grammar collecting stats.
+    match_t match(forward_token_iterator_t it, stats_t& stats) noexcept
+    {
+        return match_cardinal_number(it, grammar_engine_e::automaton, stats);
+    }
+
+    /**
+     * Converts the textual number that starts at `it`, or the token at `it` if there
+     * is none, into `out`, either an output_buffer_t or an std::string, and advances
+     * `it` past them.
+     *
+     * `Stats` is either stats_t or null_stats_t, see stats_t.
+     */
+    template<typename Out, typename Stats>
+    void convert_next(input_token_iterator_t& it, Out& out, Stats& stats) noexcept
+    {
+        if (Stats::enabled) {
+            // tokenize the lookahead beforehand, so that matching is measured on its own
+            auto timer = stats.time(stage_e::tokenize);
+            it.look_ahead() += max_lookahead;
+        }
+
+        match_t m;
+        {
+            auto timer = stats.time(stage_e::match);
+            m = match(it.look_ahead(), stats);
+        }
+
+        auto timer = stats.time(stage_e::write);
+        if (m) {
+            auto fwd_it = it.look_ahead();
+            bool write_nl = false;
+            for (auto i = 0u; i < m.size; ++i, ++fwd_it) {
+                if (has_newline(*fwd_it)) {
+                    write_nl = true;
+                    break;
+                }
+            }
+            write_match(out, it.look_ahead(), m, write_nl);
+
+            if (Stats::enabled) {
+                fwd_it = it.look_ahead();
+                for (auto i = 0u; i < m.size; ++i, ++fwd_it)
+                    stats.count_token(fwd_it->category(), fwd_it->raw_str().size());
+            }
+            it += m.size;
+        }
+        else {
+            auto str = it->raw_str();
+            write_text(out, str);
+            stats.count_token(it->category(), str.size());
+            ++it;
+        }
+    }
+
+    /// Converts the tokens of `stream` into `out`, see convert_next().
+    template<typename Out, typename Stats>
+    void convert_tokens(token_stream_t& stream, Out& out, Stats& stats) noexcept
+    {
+        input_token_iterator_t it = stream.begin();
+        while (stream) convert_next(it, out, stats);
+    }
+
+    /// Converts the tokens of `stream` into `out`, collecting stats only if `stats` is not nullptr.
+    template<typename Out>
+    void convert_tokens(token_stream_t& stream, Out& out, stats_t* stats) noexcept
+    {
+        if (stats) {
+            convert_tokens(stream, out, *stats);
+        }
+        else {
+            null_stats_t none;
+            convert_tokens(stream, out, none);
+        }
+    }
+
+    /**
+     * Converts `in` into `out`, using `stream` to tokenize it.
+     *
+     * Only the text from each position where a textual number may start (see
+     * find_number_start()) up to the next split point is tokenized and matched,
+     * the text in between is written as is.
+     */
+    template<typename Out, typename Stats>
+    void convert_text(absl::string_view in, token_stream_t& stream, Out& out, Stats& stats) noexcept
+    {
+        for (std::size_t pos = 0; pos != in.size();) {
+            std::size_t start;
+            {
+                auto timer = stats.time(stage_e::tokenize);
+                start = find_number_start(in, pos);
+            }
+            if (start != pos) {
+                auto timer = stats.time(stage_e::write);
+                write_text(out, in.substr(pos, start - pos));
+                stats.count_skipped(start - pos);
+            }
+            if (start == in.size()) break;
+
+            auto end = find_split_point(in, start + 1);
+            stream.reset(in.substr(start, end - start));
+            convert_tokens(stream, out, stats);
+            pos = end;
+        }
+    }
+
+    /// Converts `in` into `out`, collecting stats only if `stats` is not nullptr.
+    template<typename Out>
+    void convert_text(absl::string_view in, token_stream_t& stream, Out& out, stats_t* stats) noexcept
+    {
+        if (stats) {
+            convert_text(in, stream, out, *stats);
+        }
+        else {
+            null_stats_t none;
+            convert_text(in, stream, out, none);
+        }
+    }
 }
 
 namespace core {
 
-    void convert(std::istream& is, std::ostream& os) noexcept
+    void convert(std::istream& is, std::ostream& os, stats_t* stats) noexcept
     {
-        std::locale loc("en_US.UTF-8");
-        is.imbue(loc);
-        token_stream_t stream(is);
+        token_stream_t stream(is, max_lookahead);
+        output_buffer_t out(os);
+        convert_tokens(stream, out, stats);
+    }
 
-        input_token_iterator_t it = stream.begin();
-        while (stream) {
-            auto fwd_it = it.look_ahead();
-            auto m = match_cardinal_number(fwd_it);
-            if (m) {
-                bool write_nl = false;
-                for (auto i = 0u; i < m.size; ++i) {
-                    if (has_newline(*fwd_it)) {
-                        write_nl = true;
-                        break;
+    void convert(absl::string_view in, std::ostream& os, stats_t* stats) noexcept
+    {
+        token_stream_t stream(absl::string_view(), max_lookahead);
+        output_buffer_t out(os);
+        convert_text(in, stream, out, stats);
+    }
+
+    std::size_t convert_in_place(absl::string_view in, char* out, stats_t* stats) noexcept
+    {
+        // tokens are views of `in`, and the output only overwrites the ones already converted
+        token_stream_t stream(absl::string_view(), max_lookahead);
+        in_place_out_t writer{ out };
+        convert_text(in, stream, writer, stats);
+        return static_cast<std::size_t>(writer.pos - out);
+    }
+
+    converter_t::converter_t() noexcept :
+        stream_(absl::string_view(), max_lookahead)
+    {}
+
+    void converter_t::convert(absl::string_view in, std::string& out) noexcept
+    {
+        out.clear();
+        null_stats_t none;
+        convert_text(in, stream_, out, none);
+    }
+
+    void converter_t::convert(absl::string_view in, std::string& out, stats_t& stats) noexcept
+    {
+        out.clear();
+        convert_text(in, stream_, out, stats);
+    }
+
+    std::size_t converter_t::convert(absl::string_view in, char* out) noexcept
+    {
+        in_place_out_t writer{ out };
+        null_stats_t none;
+        convert_text(in, stream_, writer, none);
+        return static_cast<std::size_t>(writer.pos - out);
+    }
+
+    std::size_t converter_t::convert(absl::string_view in, char* out, stats_t& stats) noexcept
+    {
+        in_place_out_t writer{ out };
+        convert_text(in, stream_, writer, stats);
+        return static_cast<std::size_t>(writer.pos - out);
+    }
+
+    void converter_t::find_edits(absl::string_view in, std::uint64_t offset, edit_format_e format, std::string& out) noexcept
+    {
+        out.clear();
+        edit_out_t writer{ &out, nullptr, format, offset };
+        null_stats_t none;
+        convert_text(in, stream_, writer, none);
+    }
+
+    void converter_t::find_edits(absl::string_view in, std::uint64_t offset, edit_format_e format, std::string& out, stats_t& stats) noexcept
+    {
+        out.clear();
+        edit_out_t writer{ &out, nullptr, format, offset };
+        convert_text(in, stream_, writer, stats);
+    }
+
+    push_converter_t::push_converter_t() noexcept :
+        complete_(0), stream_(absl::string_view(), max_lookahead)
+    {}
+
+    void push_converter_t::feed(absl::string_view chunk, std::string& out) noexcept
+    {
+        null_stats_t none;
+        feed_chunk(chunk, out, none);
+    }
+
+    void push_converter_t::feed(absl::string_view chunk, std::string& out, stats_t& stats) noexcept
+    {
+        feed_chunk(chunk, out, stats);
+    }
+
+    void push_converter_t::finish(std::string& out) noexcept
+    {
+        null_stats_t none;
+        finish_input(out, none);
+    }
+
+    void push_converter_t::finish(std::string& out, stats_t& stats) noexcept
+    {
+        finish_input(out, stats);
+    }
+
+    template<typename Stats>
+    void push_converter_t::feed_chunk(absl::string_view chunk, std::string& out, Stats& stats) noexcept
+    {
+        out.clear();
+        if (chunk.empty()) return;
+
+        // a character split between chunks is not classified until it is complete
+        auto old_end = pending_.size() - incomplete_char_size(pending_.data(), pending_.data() + pending_.size());
+        auto old_complete = complete_;
+        pending_.append(chunk.data(), chunk.size());
+        auto first = pending_.data();
+        auto end = pending_.size() - incomplete_char_size(first, first + pending_.size());
+        if (end == old_end) return;
+
+        // the last token may continue in the next chunk, so only the text up to its
+        // start is complete, which is unchanged if the chunk just extends that token
+        auto last = static_cast<std::size_t>(token_begin(first + old_end, first + end) - first);
+        auto t = classify_char(first + last, first + end);
+        if (last != old_end || old_end == 0 || classify_char(char_begin(first, first + old_end - 1, first + end), first + end) != t)
+            complete_ = last;
+
+        // the conversion up to the last split point is final, and so are the spaces
+        // after it even if they are not complete, as no textual number starts with a space
+        auto split = rfind_split_point(absl::string_view(pending_).substr(0, complete_));
+        if (split == complete_ && t == token_category_e::space) split = end;
+        if (split != 0) {
+            convert_text(absl::string_view(pending_).substr(0, split), stream_, out, stats);
+            pending_.erase(0, split);
+            complete_ -= std::min(split, complete_);
+        }
+        else if (complete_ == old_complete) {
+            return;
+        }
+
+        // the grammar examines at most max_lookahead tokens, so the conversion of a
+        // token is also final once as many complete tokens follow it
+        stream_.reset(absl::string_view(pending_).substr(0, complete_));
+        input_token_iterator_t it = stream_.begin();
+        while (!(it.look_ahead() + max_lookahead)->is_end())
+            convert_next(it, out, stats);
+
+        auto consumed = it->is_end() ? complete_ : static_cast<std::size_t>(it->raw_str().data() - pending_.data());
+        pending_.erase(0, consumed);
+        complete_ -= consumed;
+    }
+
+    template<typename Stats>
+    void push_converter_t::finish_input(std::string& out, Stats& stats) noexcept
+    {
+        out.clear();
+        convert_text(pending_, stream_, out, stats);
+        pending_.clear();
+        complete_ = 0;
+    }
+
+    void convert(absl::string_view in, std::ostream& os, std::size_t jobs, std::size_t chunk_size, stats_t* stats) noexcept
+    {
+        if (jobs == 0) jobs = std::max(1u, std::thread::hardware_concurrency());
+        if (jobs == 1) {
+            convert(in, os, stats);
+            return;
+        }
+        chunk_size = std::max<std::size_t>(chunk_size, 1);
+
+        // split the text at points that no textual number can span
+        std::vector<absl::string_view> chunks;
+        for (std::size_t pos = 0; pos != in.size();) {
+            auto end = find_split_point(in, std::min(pos + chunk_size, in.size()));
+            chunks.push_back(in.substr(pos, end - pos));
+            pos = end;
+        }
+
+        if (chunks.size() <= 1) {
+            convert(in, os, stats);
+            return;
+        }
+
+        // workers convert the chunks, which are stitched in order as soon as they are available
+        auto threads = task_threads(chunks.size(), jobs);
+        std::vector<converter_t> converters(threads);
+        std::vector<stats_t> worker_stats(threads);
+
+        // the writer thread only measures time, the counters come from the workers
+        stats_t writer_stats;
+
+        run_ordered_tasks(chunks.size(), jobs, [&](std::size_t idx, std::size_t thread, std::string& out) {
+            if (stats) converters[thread].convert(chunks[idx], out, worker_stats[thread]);
+            else       converters[thread].convert(chunks[idx], out);
+        }, [&](std::size_t, std::string& output) {
+            auto timer = writer_stats.time(stage_e::write);
+            os.write(output.data(), static_cast<std::streamsize>(output.size()));
+        });
+
+        if (stats) {
+            for (auto& s : worker_stats) stats->merge(s);
+            stats->merge(writer_stats);
+        }
+    }
+
+    void find_edits(std::istream& is, std::ostream& os, edit_format_e format, stats_t* stats) noexcept
+    {
+        std::string buffer;
+        if (format == edit_format_e::binary) buffer.assign(edit_magic.data(), edit_magic.size());
+
+        token_stream_t stream(is, max_lookahead);
+        edit_out_t writer{ &buffer, &os, format, 0 };
+        convert_tokens(stream, writer, stats);
+        os.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    }
+
+    void find_edits(absl::string_view in, std::ostream& os, edit_format_e format, std::size_t jobs, std::size_t chunk_size, stats_t* stats) noexcept
+    {
+        if (format == edit_format_e::binary) os.write(edit_magic.data(), static_cast<std::streamsize>(edit_magic.size()));
+        chunk_size = std::max<std::size_t>(chunk_size, 1);
+
+        // split the text at points that no textual number can span
+        std::vector<absl::string_view> chunks;
+        for (std::size_t pos = 0; pos != in.size();) {
+            auto end = find_split_point(in, std::min(pos + chunk_size, in.size()));
+            chunks.push_back(in.substr(pos, end - pos));
+            pos = end;
+        }
+
+        auto threads = task_threads(chunks.size(), jobs);
+        std::vector<converter_t> converters(threads);
+        std::vector<stats_t> worker_stats(threads);
+
+        // the writer thread only measures time, the counters come from the workers
+        stats_t writer_stats;
+
+        run_ordered_tasks(chunks.size(), jobs, [&](std::size_t idx, std::size_t thread, std::string& out) {
+            auto offset = static_cast<std::uint64_t>(chunks[idx].data() - in.data());
+            if (stats) converters[thread].find_edits(chunks[idx], offset, format, out, worker_stats[thread]);
+            else       converters[thread].find_edits(chunks[idx], offset, format, out);
+        }, [&](std::size_t, std::string& output) {
+            auto timer = writer_stats.time(stage_e::write);
+            os.write(output.data(), static_cast<std::streamsize>(output.size()));
+        });
+
+        if (stats) {
+            for (auto& s : worker_stats) stats->merge(s);
+            stats->merge(writer_stats);
+        }
+    }
+
+    void convert_pipelined(std::istream& is, std::ostream& os, std::size_t queue_depth, stats_t* stats) noexcept
+    {
+        // each stage measures its own time, which is only reported if requested
+        stats_t reader_stats, tokenizer_stats, matcher_stats, writer_stats;
+
+        spsc_queue_t<std::string> blocks(queue_depth);
+        spsc_queue_t<std::string> chunks(queue_depth);
+        spsc_queue_t<std::string> outputs(queue_depth);
+
+        // reading a tied stream flushes the output, which is written by another thread
+        auto tied = is.tie(nullptr);
+
+        // reader: reads the input in blocks
+        std::thread reader([&]() {
+            for (;;) {
+                std::string block(token_stream_t::block_size, '\0');
+                {
+                    auto timer = reader_stats.time(stage_e::read);
+                    is.read(&block[0], static_cast<std::streamsize>(block.size()));
+                }
+                block.resize(static_cast<std::size_t>(is.gcount()));
+                if (block.empty()) break;
+                blocks.push(std::move(block));
+            }
+            blocks.close();
+        });
+
+        // tokenizer: joins the blocks into chunks that end at split points (see
+        // find_split_point()), so that they can be matched independently
+        std::thread tokenizer([&]() {
+            std::string pending, block;
+            std::size_t scanned = 0;
+            while (blocks.pop(block)) {
+                std::size_t split;
+                {
+                    auto timer = tokenizer_stats.time(stage_e::tokenize);
+                    pending += block;
+
+                    // the last token may continue in the next block, so only the complete
+                    // tokens, the ones before the last category change, are examined,
+                    // and neither a character that is split between blocks
+                    auto first = pending.data();
+                    auto end = first + pending.size();
+                    end -= incomplete_char_size(first, end);
+                    auto last = static_cast<std::size_t>(token_begin(first, end) - first);
+
+                    auto complete = absl::string_view(pending).substr(0, last);
+                    auto pos = std::max(scanned, std::min(token_stream_t::block_size, last));
+                    split = find_split_point(complete, pos);
+                    if (split == 0 || split == last) {
+                        scanned = last;
+                        continue;
                     }
                 }
-                if (write_nl) os << "\n";
-                os << std::to_string(m.num);
-                it += m.size;
+
+                chunks.push(pending.substr(0, split));
+                pending.erase(0, split);
+                scanned = 0;
             }
-            else {
-                os << it->raw_str();
-                ++it;
+            if (!pending.empty()) chunks.push(std::move(pending));
+            chunks.close();
+        });
+
+        // matcher: converts each chunk
+        std::thread matcher([&]() {
+            converter_t converter;
+            std::string chunk, out;
+            while (chunks.pop(chunk)) {
+                if (stats) converter.convert(chunk, out, matcher_stats);
+                else       converter.convert(chunk, out);
+                outputs.push(std::move(out));
             }
+            outputs.close();
+        });
+
+        // writer: the calling thread writes the converted chunks in order
+        std::string output;
+        while (outputs.pop(output)) {
+            auto timer = writer_stats.time(stage_e::write);
+            os.write(output.data(), static_cast<std::streamsize>(output.size()));
         }
+
+        reader.join();
+        tokenizer.join();
+        matcher.join();
+        is.tie(tied);
+
+        if (stats) {
+            stats->merge(reader_stats);
+            stats->merge(tokenizer_stats);
+            stats->merge(matcher_stats);
+            stats->merge(writer_stats);
+        }
+    }
+
+    void convert_interactive(std::istream& is, std::ostream& os, std::chrono::milliseconds max_hold, stats_t* stats) noexcept
+    {
+        std::deque<std::string> chunks;
+        bool closed = false;
+        std::mutex mutex;
+        std::condition_variable cv;
+
+        // reading a tied stream flushes the output, which is written by another thread
+        auto tied = is.tie(nullptr);
+
+        // reader: waits for the next character, and then takes all the characters
+        // that are already buffered, so that no read blocks for more input than needed
+        std::thread reader([&]() {
+            std::vector<char> buffer(token_stream_t::block_size);
+            for (;;) {
+                auto c = is.get();
+                if (c == std::istream::traits_type::eof()) break;
+                buffer[0] = std::istream::traits_type::to_char_type(c);
+                auto n = is.readsome(buffer.data() + 1, static_cast<std::streamsize>(buffer.size() - 1));
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    chunks.emplace_back(buffer.data(), static_cast<std::size_t>(n) + 1);
+                }
+                cv.notify_one();
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                closed = true;
+            }
+            cv.notify_one();
+        });
+
+        // the calling thread converts the chunks as they arrive
+        push_converter_t converter;
+        std::string chunk, out;
+        auto held_since = std::chrono::steady_clock::now();
+
+        for (;;) {
+            bool timeout = false;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                auto ready = [&]{ return closed || !chunks.empty(); };
+                if (!converter.has_pending())                               cv.wait(lock, ready);
+                else if (!cv.wait_until(lock, held_since + max_hold, ready)) timeout = true;
+
+                if (!timeout) {
+                    if (chunks.empty()) break;
+                    chunk.swap(chunks.front());
+                    chunks.pop_front();
+                }
+            }
+
+            if (timeout) {
+                // nothing decided the held text in time, so it is converted as it is
+                if (stats) converter.finish(out, *stats);
+                else       converter.finish(out);
+                os.write(out.data(), static_cast<std::streamsize>(out.size()));
+                os.flush();
+                continue;
+            }
+
+            bool held = converter.has_pending();
+            if (stats) converter.feed(chunk, out, *stats);
+            else       converter.feed(chunk, out);
+            if (!held) held_since = std::chrono::steady_clock::now();
+
+            os.write(out.data(), static_cast<std::streamsize>(out.size()));
+            if (out.find('\n') != std::string::npos) os.flush();
+        }
+
+        if (stats) converter.finish(out, *stats);
+        else       converter.finish(out);
+        os.write(out.data(), static_cast<std::streamsize>(out.size()));
+        os.flush();
+
+        reader.join();
+        is.tie(tied);
     }
 
 }
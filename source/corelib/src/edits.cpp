@@ -0,0 +1,261 @@
+#include "core/edits.h"
+#include "core/output.h"
+
+#include "absl/strings/numbers.h"
+
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+namespace {
+    using namespace core;
+
+    /// Appends `n` as 8 bytes in little endian.
+    void append_le(std::string& out, std::uint64_t n) noexcept
+    {
+        char bytes[8];
+        for (auto& b : bytes) {
+            b = static_cast<char>(n & 0xff);
+            n >>= 8;
+        }
+        out.append(bytes, sizeof(bytes));
+    }
+
+    /// Reads 8 bytes in little endian.
+    std::uint64_t read_le(const char* bytes) noexcept
+    {
+        std::uint64_t n = 0;
+        for (int i = 7; i >= 0; --i) n = (n << 8) | static_cast<unsigned char>(bytes[i]);
+        return n;
+    }
+
+    /// Appends a JSON member of a number, preceded by `prefix`.
+    void append_member(std::string& out, absl::string_view prefix, std::uint64_t n) noexcept
+    {
+        char digits[max_uint_digits];
+        out.append(prefix.data(), prefix.size());
+        out.append(digits, format_uint(n, digits));
+    }
+
+    /// Skips the whitespace at `p`.
+    const char* skip_space(const char* p, const char* last) noexcept
+    {
+        while (p != last && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+        return p;
+    }
+
+    /**
+     * Parses a JSON object of an edit, whose members are unsigned integers or booleans.
+     *
+     * @returns Whether `line` is such an object with at least the offset, length and value.
+     */
+    bool parse_edit(absl::string_view line, edit_t& edit) noexcept
+    {
+        auto p = line.data();
+        auto last = p + line.size();
+        bool offset = false, length = false, value = false;
+        edit.newline = false;
+
+        p = skip_space(p, last);
+        if (p == last || *p++ != '{') return false;
+        for (bool first = true;; first = false) {
+            p = skip_space(p, last);
+            if (p != last && *p == '}' && first) { ++p; break; }
+            if (p == last || *p++ != '"') return false;
+            auto key_first = p;
+            p = std::find(p, last, '"');
+            if (p == last) return false;
+            absl::string_view key(key_first, static_cast<std::size_t>(p - key_first));
+
+            p = skip_space(p + 1, last);
+            if (p == last || *p++ != ':') return false;
+            p = skip_space(p, last);
+
+            auto value_first = p;
+            while (p != last && ((*p >= '0' && *p <= '9') || (*p >= 'a' && *p <= 'z'))) ++p;
+            absl::string_view text(value_first, static_cast<std::size_t>(p - value_first));
+
+            std::uint64_t n = 0;
+            if (key == "newline") {
+                if (text != "true" && text != "false") return false;
+                edit.newline = text == "true";
+            }
+            else if (text.empty() || text[0] < '0' || text[0] > '9' || !absl::SimpleAtoi(text, &n)) {
+                return false;
+            }
+            else if (key == "offset") { edit.offset = n; offset = true; }
+            else if (key == "length") { edit.length = n; length = true; }
+            else if (key == "value")  { edit.value = n; value = true; }
+
+            p = skip_space(p, last);
+            if (p == last) return false;
+            if (*p == '}') { ++p; break; }
+            if (*p++ != ',') return false;
+        }
+        return offset && length && value && skip_space(p, last) == last;
+    }
+
+    /// Original text of apply_edits() that is already in memory.
+    struct view_source_t {
+        absl::string_view text; //!< Text not consumed yet.
+
+        /// Writes the next `n` characters to `out`, returns false if there are not as many.
+        bool copy(std::uint64_t n, output_buffer_t& out) noexcept
+        {
+            if (n > text.size()) return false;
+            out.write(text.substr(0, static_cast<std::size_t>(n)));
+            text.remove_prefix(static_cast<std::size_t>(n));
+            return true;
+        }
+
+        /// Skips the next `n` characters, returns false if there are not as many.
+        bool skip(std::uint64_t n) noexcept
+        {
+            if (n > text.size()) return false;
+            text.remove_prefix(static_cast<std::size_t>(n));
+            return true;
+        }
+
+        /// Writes the rest of the text to `out`.
+        void copy_rest(output_buffer_t& out) noexcept
+        {
+            out.write(text);
+            text = absl::string_view();
+        }
+    };
+
+    /// Original text of apply_edits() that is read from a stream.
+    struct stream_source_t {
+        std::istream* is;           //!< Stream with the text not consumed yet.
+        std::vector<char> block;    //!< Text being copied.
+
+        /// Reads up to `n` characters into `block`, returns how many.
+        std::size_t read(std::uint64_t n) noexcept
+        {
+            auto size = static_cast<std::size_t>(std::min<std::uint64_t>(n, block.size()));
+            is->read(block.data(), static_cast<std::streamsize>(size));
+            return static_cast<std::size_t>(is->gcount());
+        }
+
+        /// Writes the next `n` characters to `out`, returns false if there are not as many.
+        bool copy(std::uint64_t n, output_buffer_t& out) noexcept
+        {
+            while (n != 0) {
+                auto size = read(n);
+                if (size == 0) return false;
+                out.write(absl::string_view(block.data(), size));
+                n -= size;
+            }
+            return true;
+        }
+
+        /// Skips the next `n` characters, returns false if there are not as many.
+        bool skip(std::uint64_t n) noexcept
+        {
+            while (n != 0) {
+                auto size = read(n);
+                if (size == 0) return false;
+                n -= size;
+            }
+            return true;
+        }
+
+        /// Writes the rest of the text to `out`.
+        void copy_rest(output_buffer_t& out) noexcept
+        {
+            while (auto size = read(block.size())) out.write(absl::string_view(block.data(), size));
+        }
+    };
+
+    /// Implementation of apply_edits(), `Source` is either view_source_t or stream_source_t.
+    template<typename Source>
+    bool apply(Source& source, std::istream& edits, std::ostream& os) noexcept
+    {
+        output_buffer_t out(os);
+        edit_reader_t reader(edits);
+        edit_t edit;
+        std::uint64_t pos = 0;
+        while (reader.next(edit)) {
+            if (edit.offset < pos || !source.copy(edit.offset - pos, out) || !source.skip(edit.length))
+                return false;
+            if (edit.newline) out.write("\n");
+            out.write(edit.value);
+            pos = edit.offset + edit.length;
+        }
+        if (reader.failed()) return false;
+        source.copy_rest(out);
+        return true;
+    }
+}
+
+namespace core {
+
+    void append_edit(std::string& out, const edit_t& edit, edit_format_e format) noexcept
+    {
+        if (format == edit_format_e::binary) {
+            append_le(out, edit.offset);
+            append_le(out, edit.length);
+            append_le(out, edit.value);
+            append_le(out, edit.newline ? 1 : 0);
+            return;
+        }
+
+        append_member(out, "{\"offset\":", edit.offset);
+        append_member(out, ",\"length\":", edit.length);
+        append_member(out, ",\"value\":", edit.value);
+        out += edit.newline ? ",\"newline\":true}\n" : "}\n";
+    }
+
+    edit_reader_t::edit_reader_t(std::istream& is) noexcept :
+        is_(&is), format_(edit_format_e::jsonl), failed_(false)
+    {
+        if (is.peek() != edit_magic[0]) return;
+
+        char magic[edit_magic.size()];
+        is.read(magic, static_cast<std::streamsize>(sizeof(magic)));
+        format_ = edit_format_e::binary;
+        failed_ = static_cast<std::size_t>(is.gcount()) != sizeof(magic) || absl::string_view(magic, sizeof(magic)) != edit_magic;
+    }
+
+    bool edit_reader_t::next(edit_t& edit) noexcept
+    {
+        if (failed_) return false;
+
+        if (format_ == edit_format_e::binary) {
+            char record[edit_record_size];
+            is_->read(record, static_cast<std::streamsize>(sizeof(record)));
+            auto size = static_cast<std::size_t>(is_->gcount());
+            if (size != sizeof(record)) {
+                failed_ = size != 0;
+                return false;
+            }
+            edit.offset = read_le(record);
+            edit.length = read_le(record + 8);
+            edit.value = read_le(record + 16);
+            edit.newline = (read_le(record + 24) & 1) != 0;
+            return true;
+        }
+
+        // blank lines are skipped
+        while (std::getline(*is_, line_)) {
+            if (skip_space(line_.data(), line_.data() + line_.size()) == line_.data() + line_.size()) continue;
+            failed_ = !parse_edit(line_, edit);
+            return !failed_;
+        }
+        return false;
+    }
+
+    bool apply_edits(absl::string_view in, std::istream& edits, std::ostream& os) noexcept
+    {
+        view_source_t source{ in };
+        return apply(source, edits, os);
+    }
+
+    bool apply_edits(std::istream& is, std::istream& edits, std::ostream& os) noexcept
+    {
+        stream_source_t source{ &is, std::vector<char>(output_buffer_t::default_block_size) };
+        return apply(source, edits, os);
+    }
+
+}
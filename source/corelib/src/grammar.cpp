@@ -1,296 +1,350 @@
 #include "core/grammar.h"
+#include "core/keyword.h"
+#include "core/stats.h"
+
+#include <atomic>
 
 namespace {
     using namespace core;
 
-    /**
-     * Matches the rule:
-     * Digit -> 'one' | 'two' | 'three' | 'four' | 'five' | 'six' | 'seven' | 'eight' | 'nine'
-     */
-    match_t rule_Digit(forward_token_iterator_t it) noexcept
+    /// Accesses the tokens examined by a rule, counting them in the stats.
+    template<typename Stats>
+    struct probe_t {
+        Stats& stats;           //!< Where examined tokens are counted.
+        grammar_rule_e rule;    //!< Rule that examines the tokens.
+
+        const token_record_t& operator()(const token_record_t* it) const noexcept
+        {
+            stats.examine(rule);
+            return *it;
+        }
+    };
+
+    /// Keeps in `best` the match of the tokens [first, last) with value `num`, if it is longer.
+    inline void keep_longest(match_t& best, const token_record_t* first, const token_record_t* last, std::uint64_t num) noexcept
     {
-        const auto& token = it->str();
-        if (token == "one")         return { 1, 1 };
-        else if (token == "two")    return { 1, 2 };
-        else if (token == "three")  return { 1, 3 };
-        else if (token == "four")   return { 1, 4 };
-        else if (token == "five")   return { 1, 5 };
-        else if (token == "six")    return { 1, 6 };
-        else if (token == "seven")  return { 1, 7 };
-        else if (token == "eight")  return { 1, 8 };
-        else if (token == "nine")   return { 1, 9 };
-        return {};
+        auto size = static_cast<std::uint64_t>(last - first);
+        if (size > best.size) best = { size, num };
     }
 
-    /**
-     * Matches the rule:
-     * Teens -> 'ten' | 'eleven' | 'twelve'  | 'thirteen' | 'fourteen' | 'fifteen' | 'sixteen' | 'seventeen' | 'eighteen' | 'nineteen'
-     */
-    match_t rule_Teens(forward_token_iterator_t it) noexcept
+    // the rules of every variant, generated from the grammar description,
+    // and match_variant(), which dispatches to the CardNum of a variant
+#include "grammar_rules.inc"
+
+    static_assert(sizeof(variant_names) / sizeof(variant_names[0]) == static_cast<std::size_t>(grammar_variant_e::count_), "a name is needed for each variant");
+
+    /// Variant matched when none is given, see set_grammar_variant().
+    std::atomic<grammar_variant_e> current_variant{ default_grammar_variant };
+
+    /// Symbols of the automaton, a token is mapped to a single symbol.
+    enum symbol_e : std::uint8_t {
+        sym_other, sym_space, sym_hyphen, sym_zero, sym_digit, sym_teen, sym_tens,
+        sym_hundred, sym_thousand, sym_million, sym_a, sym_and, sym_count
+    };
+
+    /// Returns the symbol of a token.
+    symbol_e symbol(const token_record_t& token) noexcept
     {
-        const auto& token = it->str();
-        if (token == "ten")             return { 1, 10 };
-        else if (token == "eleven")     return { 1, 11 };
-        else if (token == "twelve")     return { 1, 12 };
-        else if (token == "thirteen")   return { 1, 13 };
-        else if (token == "fifteen")    return { 1, 14 };
-        else if (token == "fourteen")   return { 1, 15 };
-        else if (token == "sixteen")    return { 1, 16 };
-        else if (token == "seventeen")  return { 1, 17 };
-        else if (token == "eighteen")   return { 1, 18 };
-        else if (token == "nineteen")   return { 1, 19 };
-        return {};
+        static const symbol_e symbols[] = {
+            sym_other,
+            sym_zero,
+            sym_digit, sym_digit, sym_digit, sym_digit, sym_digit, sym_digit, sym_digit, sym_digit, sym_digit,
+            sym_teen, sym_teen, sym_teen, sym_teen, sym_teen, sym_teen, sym_teen, sym_teen, sym_teen, sym_teen,
+            sym_tens, sym_tens, sym_tens, sym_tens, sym_tens, sym_tens, sym_tens, sym_tens,
+            sym_hundred,
+            sym_thousand,
+            sym_million,
+            sym_a,
+            sym_and,
+            sym_hyphen
+        };
+        static_assert(sizeof(symbols) / sizeof(symbols[0]) == static_cast<std::size_t>(keyword_e::count_), "a symbol is needed for each keyword");
+
+        if (token.is_space()) return sym_space;
+        return symbols[static_cast<std::size_t>(token.keyword)];
     }
 
     /**
-     * Matches the rule:
-     * SecDig -> 'twenty' | 'thirty' | 'forty' | 'fifty' | 'sixty' | 'seventy' | 'eighty' | 'ninety'
+     * Actions on the registers of the automaton when taking a transition.
+     *
+     * The value of a match is `millions + thousands + hundreds`, where `hundreds` is
+     * the value of the Hundreds being matched, `thousands` the value of the
+     * Thousands up to the last 'thousand', and `millions` the value up to 'million'.
      */
-    match_t rule_SecDig(forward_token_iterator_t it) noexcept
-    {
-        const auto& token = it->str();
-        if (token == "twenty")          return { 1, 20 };
-        else if (token == "thirty")     return { 1, 30 };
-        else if (token == "forty")      return { 1, 40 };
-        else if (token == "fifty")      return { 1, 50 };
-        else if (token == "sixty")      return { 1, 60 };
-        else if (token == "seventy")    return { 1, 70 };
-        else if (token == "eighty")     return { 1, 80 };
-        else if (token == "ninety")     return { 1, 90 };
-        return {};
-    }
+    enum action_e : std::uint8_t {
+        act_none,       //!< Registers are not modified.
+        act_set,        //!< hundreds = value of the token.
+        act_add,        //!< hundreds += value of the token.
+        act_one,        //!< hundreds = 1, for 'a'.
+        act_hundred,    //!< hundreds *= 100.
+        act_thousand,   //!< thousands = hundreds * 1000, hundreds = 0.
+        act_million     //!< millions = (thousands + hundreds) * 1000000, thousands = hundreds = 0.
+    };
 
     /**
-     * Matches the rule:
-     * Below100 -> Digit | Teens | SecDig | SecDig '-' Digit
+     * States of the automaton.
+     *
+     * A number is a sequence of Hundreds groups separated by scale words, the groups
+     * share the same states (see group_e) at four levels, which determine the scale
+     * words that may follow the group:
+     *   0. first group of the Thousands before 'million', may be followed by 'thousand' or 'million'.
+     *   1. group after 'thousand' before 'million', may be followed by 'million'.
+     *   2. first group after 'million', may be followed by 'thousand'.
+     *   3. group that cannot be followed by any scale word.
      */
-    match_t rule_Below100(forward_token_iterator_t start) noexcept
+    enum state_e : std::uint8_t {
+        st_dead,            //!< No transition, the match ended.
+        st_start,
+        st_zero,            //!< 'zero'
+        st_a,               //!< 'a'
+        st_a_sp,            //!< 'a' Space
+        st_a_hundred,       //!< 'a' Space 'hundred'
+        st_a_hundred_sp,    //!< 'a' Space 'hundred' Space
+        st_thousand0,       //!< Hundreds Space 'thousand'
+        st_thousand0_sp,    //!< Hundreds Space 'thousand' Space
+        st_million,         //!< Thousands Space 'million'
+        st_million_sp,      //!< Thousands Space 'million' Space
+        st_thousand2,       //!< 'thousand' after 'million' or 'a'
+        st_thousand2_sp,    //!< 'thousand' Space after 'million' or 'a'
+        st_groups           //!< First state of the groups, see group_state().
+    };
+
+    /// States within a Hundreds group.
+    enum group_e : std::uint8_t {
+        grp_digit,          //!< Digit
+        grp_digit_sp,       //!< Digit Space
+        grp_tens,           //!< SecDig
+        grp_tens_hyphen,    //!< SecDig '-'
+        grp_below100,       //!< Below100 that cannot be continued within the group
+        grp_sp,             //!< Below100 Space
+        grp_hundred,        //!< Digit Space 'hundred'
+        grp_hundred_sp,     //!< Digit Space 'hundred' Space
+        grp_and,            //!< Digit Space 'hundred' Space 'and'
+        grp_and_sp,         //!< Digit Space 'hundred' Space 'and' Space
+        grp_count
+    };
+
+    constexpr std::size_t group_levels = 4;
+    constexpr std::size_t state_count = st_groups + group_levels * grp_count;
+
+    /// Returns the state for `group` at `level`.
+    std::uint8_t group_state(std::size_t level, group_e group) noexcept
     {
-        match_t m;
-        if ((m = rule_SecDig(start))) {
-            // be greedy and try to match '-' Digit,
-            // if not, we need to report current match
-            auto it = start + m.size;
-
-            if (it->str() != "-") return m;
-            ++it;
-
-            match_t digit;
-            if ((digit = rule_Digit(it))) return { m.size + 1 + digit.size, m.num + digit.num };
-            return m;
-        }
-        if ((m = rule_Teens(start))) return m;
-        return rule_Digit(start);
+        return static_cast<std::uint8_t>(st_groups + level * grp_count + group);
     }
 
+    /// A transition of the automaton.
+    struct transition_t {
+        std::uint8_t next;  //!< Next state, st_dead if there is no transition.
+        action_e action;    //!< Action to perform when taking the transition.
+    };
+
     /**
-     * Matches the rule:
-     * HundredSfx   -> 'hundred' | 'hundred' Space 'and' Space Below100
+     * Deterministic automaton that recognizes the same language as the CardNum of
+     * the british variant.
+     *
+     * As the rules are greedy and the language has no prefix that can be extended
+     * in more than a way, the match of CardNum is the longest prefix accepted by the
+     * automaton, which is found in a single pass by remembering the last accepting
+     * state. It is written by hand, and the tests check that it gives the same
+     * matches as the generated rules.
      */
-    match_t rule_HundredSfx(forward_token_iterator_t it) noexcept
-    {
-        if (it->str() != "hundred") return {};
+    struct automaton_t {
+        transition_t table[state_count][sym_count];
+        bool accepting[state_count];
+        grammar_rule_e rule[state_count];   //!< Rule of the grammar whose tokens are examined in each state, for stats.
+
+        automaton_t() noexcept : table(), accepting(), rule() {
+            on(st_start, sym_zero, st_zero, act_set);
+            on(st_start, sym_a, st_a, act_one);
+            start_group(st_start, 0);
+
+            // 'a' Space HundredSfx | 'a' Space ThousandSfx | 'a' Space MillionSfx
+            on(st_a, sym_space, st_a_sp, act_none);
+            on(st_a_sp, sym_hundred, st_a_hundred, act_hundred);
+            on(st_a_sp, sym_thousand, st_thousand2, act_thousand);
+            on(st_a_sp, sym_million, st_million, act_million);
+
+            // 'a' Space 'hundred' Space ('and' Space Below100 | ThousandSfx | MillionSfx)
+            on(st_a_hundred, sym_space, st_a_hundred_sp, act_none);
+            on(st_a_hundred_sp, sym_and, group_state(3, grp_and), act_none);
+            on(st_a_hundred_sp, sym_thousand, st_thousand2, act_thousand);
+            on(st_a_hundred_sp, sym_million, st_million, act_million);
+
+            // ThousandSfx of the first Thousands, may be followed by MillionSfx
+            on(st_thousand0, sym_space, st_thousand0_sp, act_none);
+            on(st_thousand0_sp, sym_million, st_million, act_million);
+            start_group(st_thousand0_sp, 1);
+
+            // MillionSfx
+            on(st_million, sym_space, st_million_sp, act_none);
+            start_group(st_million_sp, 2);
+
+            // ThousandSfx after MillionSfx or 'a'
+            on(st_thousand2, sym_space, st_thousand2_sp, act_none);
+            start_group(st_thousand2_sp, 3);
+
+            for (std::size_t level = 0; level != group_levels; ++level) {
+                auto g = [level](group_e group) { return group_state(level, group); };
+
+                // Digit Space HundredSfx
+                on(g(grp_digit), sym_space, g(grp_digit_sp), act_none);
+                on(g(grp_digit_sp), sym_hundred, g(grp_hundred), act_hundred);
+                scales(g(grp_digit_sp), level);
+
+                // SecDig '-' Digit
+                on(g(grp_tens), sym_hyphen, g(grp_tens_hyphen), act_none);
+                on(g(grp_tens), sym_space, g(grp_sp), act_none);
+                on(g(grp_tens_hyphen), sym_digit, g(grp_below100), act_add);
+
+                on(g(grp_below100), sym_space, g(grp_sp), act_none);
+                scales(g(grp_sp), level);
+
+                // 'hundred' Space 'and' Space Below100
+                on(g(grp_hundred), sym_space, g(grp_hundred_sp), act_none);
+                on(g(grp_hundred_sp), sym_and, g(grp_and), act_none);
+                scales(g(grp_hundred_sp), level);
+                on(g(grp_and), sym_space, g(grp_and_sp), act_none);
+                on(g(grp_and_sp), sym_digit, g(grp_below100), act_add);
+                on(g(grp_and_sp), sym_teen, g(grp_below100), act_add);
+                on(g(grp_and_sp), sym_tens, g(grp_tens), act_add);
+
+                accepting[g(grp_digit)] = true;
+                accepting[g(grp_tens)] = true;
+                accepting[g(grp_below100)] = true;
+                accepting[g(grp_hundred)] = true;
+            }
 
-        match_t m = { 1, 100 };
-        ++it;
+            // states that continue a match after a complete group or scale word
+            // are examined on behalf of the rule that may extend it
+            rule[st_start] = rule[st_zero] = grammar_rule_e::CardNum;
+            rule[st_a] = rule[st_a_sp] = rule[st_a_hundred] = rule[st_a_hundred_sp] = grammar_rule_e::AValue;
+            rule[st_thousand0] = rule[st_thousand0_sp] = grammar_rule_e::ThousandSfx;
+            rule[st_thousand2] = rule[st_thousand2_sp] = grammar_rule_e::ThousandSfx;
+            rule[st_million] = rule[st_million_sp] = grammar_rule_e::MillionSfx;
+            for (std::size_t level = 0; level != group_levels; ++level) {
+                auto g = [level](group_e group) { return group_state(level, group); };
+                auto scale_rule = level == 1 ? grammar_rule_e::Millions : level == 3 ? grammar_rule_e::Hundreds : grammar_rule_e::Thousands;
+                rule[g(grp_digit)] = grammar_rule_e::Hundreds;
+                rule[g(grp_digit_sp)] = scale_rule;
+                rule[g(grp_tens)] = rule[g(grp_tens_hyphen)] = rule[g(grp_below100)] = grammar_rule_e::Below100;
+                rule[g(grp_sp)] = scale_rule;
+                rule[g(grp_hundred)] = rule[g(grp_hundred_sp)] = rule[g(grp_and)] = rule[g(grp_and_sp)] = grammar_rule_e::HundredSfx;
+            }
 
-        // be greedy and try to match Space 'and' Space Below100,
-        // however, if cannot match, return current match
-        if (!it->is_space()) return m;
-        ++it;
+            accepting[st_zero] = true;
+            accepting[st_a_hundred] = true;
+            accepting[st_thousand0] = true;
+            accepting[st_million] = true;
+            accepting[st_thousand2] = true;
+        }
 
-        if (it->str() != "and") return m;
-        ++it;
+        void on(std::uint8_t from, symbol_e sym, std::uint8_t to, action_e action) noexcept {
+            table[from][sym] = { to, action };
+        }
 
-        if (!it->is_space()) return m;
-        ++it;
+        /// Transitions from `from` to the start of a group at `level`.
+        void start_group(std::uint8_t from, std::size_t level) noexcept {
+            on(from, sym_digit, group_state(level, grp_digit), act_set);
+            on(from, sym_teen, group_state(level, grp_below100), act_set);
+            on(from, sym_tens, group_state(level, grp_tens), act_set);
+        }
 
-        match_t inner_match;
-        if ((inner_match = rule_Below100(it))) return { inner_match.size + m.size + 3, 100 + inner_match.num };
+        /// Transitions from `from`, after a complete group at `level` and a Space, to the scale words.
+        void scales(std::uint8_t from, std::size_t level) noexcept {
+            if (level == 0) on(from, sym_thousand, st_thousand0, act_thousand);
+            if (level == 2) on(from, sym_thousand, st_thousand2, act_thousand);
+            if (level <= 1) on(from, sym_million, st_million, act_million);
+        }
+    };
 
-        return m;
-    }
+    const automaton_t automaton;
 
-    /**
-     * Matches the rule:
-     * Hundreds -> Below100 | Digit Space HundredSfx
-     */
-    match_t rule_Hundreds(forward_token_iterator_t it) noexcept
+    /// Matches CardNum with the automaton, examining each token once.
+    template<typename Stats>
+    match_t run_automaton(const token_record_t* it, Stats& stats) noexcept
     {
-        // warning: Below100 and Digit share prefix
-        //          try to match Below100, and if the number is below 10
-        //          try to match HundredSfx
-        match_t m;
-        if ((m = rule_Below100(it))) {
-
-            // Check if Digit Space HundedSfx rule is still valid.
-            if (m.num < 10) {
-                match_t hundredsfx_match;
-                it += m.size;
-
-                if (!it->is_space()) return m;
-                ++it;
-
-                if ((hundredsfx_match = rule_HundredSfx(it)))
-                    return { m.size + 1 + hundredsfx_match.size, m.num * 100 + (hundredsfx_match.num - 100) };
+        match_t m = {};
+        std::uint64_t size = 0;
+        std::uint64_t millions = 0, thousands = 0, hundreds = 0;
+
+        std::uint8_t state = st_start;
+        for (;;) {
+            stats.examine(automaton.rule[state]);
+            const auto& t = automaton.table[state][symbol(*it)];
+            if (t.next == st_dead) return m;
+
+            switch (t.action) {
+            case act_none:      break;
+            case act_set:       hundreds = keyword_value(it->keyword); break;
+            case act_add:       hundreds += keyword_value(it->keyword); break;
+            case act_one:       hundreds = 1; break;
+            case act_hundred:   hundreds *= 100; break;
+            case act_thousand:  thousands = hundreds * 1000; hundreds = 0; break;
+            case act_million:   millions = (thousands + hundreds) * 1000000; thousands = hundreds = 0; break;
             }
-            return m;
-        }
 
-        return {};
+            state = t.next;
+            ++size;
+            if (automaton.accepting[state]) m = { size, millions + thousands + hundreds };
+            ++it;
+        }
     }
 
-    /**
-     * Matches the rule:
-     * ThousandSfx  -> 'thousand' | 'thousand' Space Hundreds
-     */
-    match_t rule_ThousandSfx(forward_token_iterator_t it) noexcept
+    template<typename Stats>
+    match_t match(forward_token_iterator_t it, grammar_variant_e variant, grammar_engine_e engine, Stats& stats) noexcept
     {
-        if (it->str() != "thousand") return {};
-        match_t m = { 1, 1000 };
-        ++it;
-
-        // be greedy and try to match Hundreds
-        if (!it->is_space()) return m;
-        ++it;
-
-        match_t hundreds_match;
-        if ((hundreds_match = rule_Hundreds(it)))
-            return { m.size + 1 + hundreds_match.size, 1000 + hundreds_match.num };
-
+        // the rules never look past max_lookahead tokens, nor past the end token
+        auto tokens = it.records(max_lookahead);
+        auto m = engine == grammar_engine_e::automaton && variant == grammar_variant_e::british
+               ? run_automaton(tokens, stats)
+               : match_variant(tokens, variant, stats);
+        stats.count_match(m.size);
         return m;
     }
+}
 
-    /**
-     * Matches the rule:
-     * Thousands    -> Hundreds | Hundreds Space ThousandSfx
-     */
-    match_t rule_Thousands(forward_token_iterator_t it) noexcept
+namespace core {
+    void set_grammar_variant(grammar_variant_e variant) noexcept
     {
-        match_t m;
-        if ((m = rule_Hundreds(it))) {
-
-            // try to match the rule Hundreds Space ThousandSfx
-            it += m.size;
-
-            if (!it->is_space()) return m;
-            ++it;
-
-            match_t m2;
-            if ((m2 = rule_ThousandSfx(it)))
-                return { m.size + 1 + m2.size, 1000 * m.num + (m2.num-1000) };
-
-            return m;
-        }
-
-        return {};
+        current_variant.store(variant, std::memory_order_relaxed);
     }
 
-    /**
-     * Matches the rule:
-     * MillionSfx   -> 'million' | 'million' Space Thousands
-     */
-    match_t rule_MillionSfx(forward_token_iterator_t it) noexcept
+    grammar_variant_e grammar_variant() noexcept
     {
-        if (it->str() != "million") return {};
-        match_t m = { 1, 1000000 };
-        ++it;
-
-        // be greedy and try to match Space Thousands
-        if (!it->is_space()) return m;
-        ++it;
-
-        match_t m2;
-        if ((m2 = rule_Thousands(it)))
-            return { m.size + 1 + m2.size, 1000000 + m2.num };
-
-        return m;
+        return current_variant.load(std::memory_order_relaxed);
     }
 
-    /**
-     * Matches the rule:
-     * Millions    -> Thousands | Thousands Space MillionSfx
-     */
-    match_t rule_Millions(forward_token_iterator_t it) noexcept
+    const char* grammar_variant_name(grammar_variant_e variant) noexcept
     {
-        match_t m;
-        if ((m = rule_Thousands(it))) {
-
-            // try to match Space MillionSfx
-            it += m.size;
-
-            if (!it->is_space()) return m;
-            ++it;
-
-            match_t m2;
-            if ((m2 = rule_MillionSfx(it)))
-                return { m.size + 1 + m2.size, 1000000 * m.num + (m2.num-1000000) };
-
-            return m;
-        }
-
-        return {};
+        return variant < grammar_variant_e::count_ ? variant_names[static_cast<std::size_t>(variant)] : "unknown";
     }
 
-    /**
-     * Matches the rule:
-     * AValue -> 'a' Space HundredSfx | 'a' Space 'hundred' Space ThousandSfx | 'a' Space 'hundred' Space MillionSfx  | 'a' Space ThousandSfx | 'a' Space MillionSfx
-     */
-    match_t rule_AValue(forward_token_iterator_t it) noexcept
+    bool find_grammar_variant(absl::string_view name, grammar_variant_e& variant) noexcept
     {
-        // 'a'
-        if (it->str() != "a") return {};
-        ++it;
-
-        // 'a' Space
-        if (!it->is_space()) return {};
-        ++it;
-
-        // treat all the 'a' Space 'hundred' cases
-        // 'a' Space HundredSfx | 'a' Space 'hundred' Space ThousandSfx | 'a' Space 'hundred' Space MillionSfx
-        match_t m;
-        if ((m = rule_HundredSfx(it))) {
-            it += m.size;
-            m.size += 2; // include 'a' Space
-
-            // check that the text is actually 'hundred' alone in order to match
-            // 'a' Space 'hundred' Space ThousandSfx | 'a' Space 'hundred' Space MillionSfx
-            if (m.num == 100) {
-
-                // 'a' Space 'hundred' Space
-                if (!it->is_space()) return m;
-                ++it;
-
-                match_t m2;
-
-                // 'a' Space 'hundred' Space ThousandSfx
-                if ((m2 = rule_ThousandSfx(it))) return { m.size + 1 + m2.size, (m2.num - 1000) + 100000 };
-
-                // 'a' Space 'hundred' Space MillionSfx
-                if ((m2 = rule_MillionSfx(it))) return { m.size + 1 + m2.size, (m2.num - 1000000) + 100000000 };
+        for (std::size_t i = 0; i != static_cast<std::size_t>(grammar_variant_e::count_); ++i) {
+            if (name == variant_names[i]) {
+                variant = static_cast<grammar_variant_e>(i);
+                return true;
             }
-
-            // matched rule was 'a' Space HundredSfx
-            return m;
         }
+        return false;
+    }
 
-        // handle rule 'a' Space ThousandSfx
-        if ((m = rule_ThousandSfx(it))) return { m.size + 2, m.num };
-
-        // handle rule 'a' Space MillionSfx
-        if ((m = rule_MillionSfx(it))) return { m.size + 2, m.num };
+    match_t match_cardinal_number(forward_token_iterator_t it, grammar_engine_e engine) noexcept
+    {
+        null_stats_t stats;
+        return match(it, grammar_variant(), engine, stats);
+    }
 
-        return {};
+    match_t match_cardinal_number(forward_token_iterator_t it, grammar_engine_e engine, stats_t& stats) noexcept
+    {
+        return match(it, grammar_variant(), engine, stats);
     }
-}
 
-namespace core {
-    match_t match_cardinal_number(forward_token_iterator_t it) noexcept
+    match_t match_cardinal_number(forward_token_iterator_t it, grammar_variant_e variant, grammar_engine_e engine) noexcept
     {
-        // CardNum -> 'zero' | Millions | AValue
-        match_t m;
-        if (it->str() == "zero") return { 1, 0 };
-        else if ((m = rule_AValue(it))) return m;
-        return rule_Millions(it);
+        null_stats_t stats;
+        return match(it, variant, engine, stats);
     }
 }
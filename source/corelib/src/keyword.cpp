@@ -0,0 +1,107 @@
+#include "core/keyword.h"
+
+namespace {
+    using namespace core;
+
+    /// Text of each keyword, indexed by keyword_e.
+    constexpr const char* texts[] = {
+        "",
+        "zero",
+        "one", "two", "three", "four", "five", "six", "seven", "eight", "nine",
+        "ten", "eleven", "twelve", "thirteen", "fourteen", "fifteen", "sixteen", "seventeen", "eighteen", "nineteen",
+        "twenty", "thirty", "forty", "fifty", "sixty", "seventy", "eighty", "ninety",
+        "hundred",
+        "thousand",
+        "million",
+        "a",
+        "and",
+        "-"
+    };
+
+    static_assert(sizeof(texts) / sizeof(texts[0]) == static_cast<std::size_t>(keyword_e::count_), "a text is needed for each keyword");
+
+    constexpr std::size_t length(const char* text) noexcept
+    {
+        return *text ? 1 + length(text + 1) : 0;
+    }
+
+    /**
+     * Perfect hash of the words of the lexicon, found by exhaustive search of the
+     * coefficients. Letters are folded to lowercase so that the same hash can be
+     * computed on text of any case.
+     */
+    constexpr std::size_t hash(const char* text, std::size_t n) noexcept
+    {
+        return ((text[0] | 0x20) + 16 * (text[n > 1 ? 1 : 0] | 0x20) + 11 * (text[n - 1] | 0x20) + 37 * n) & 63;
+    }
+
+    /// Keyword of each hash value.
+    constexpr keyword_e table[64] = {
+        keyword_e::sixteen, keyword_e::a, keyword_e::forty, keyword_e::none, keyword_e::three, keyword_e::thirty, keyword_e::eighty, keyword_e::hundred,
+        keyword_e::none, keyword_e::none, keyword_e::seventeen, keyword_e::none, keyword_e::none, keyword_e::none, keyword_e::none, keyword_e::ninety,
+        keyword_e::four, keyword_e::none, keyword_e::none, keyword_e::none, keyword_e::none, keyword_e::one, keyword_e::thirteen, keyword_e::eighteen,
+        keyword_e::two, keyword_e::twelve, keyword_e::six, keyword_e::none, keyword_e::none, keyword_e::none, keyword_e::none, keyword_e::none,
+        keyword_e::nineteen, keyword_e::five, keyword_e::fifty, keyword_e::zero, keyword_e::none, keyword_e::none, keyword_e::none, keyword_e::none,
+        keyword_e::thousand, keyword_e::nine, keyword_e::eight, keyword_e::none, keyword_e::none, keyword_e::ten, keyword_e::none, keyword_e::sixty,
+        keyword_e::none, keyword_e::none, keyword_e::none, keyword_e::fifteen, keyword_e::none, keyword_e::twenty, keyword_e::seven, keyword_e::none,
+        keyword_e::fourteen, keyword_e::seventy, keyword_e::million, keyword_e::none, keyword_e::and_, keyword_e::eleven, keyword_e::none, keyword_e::none,
+    };
+
+    /// Checks at compile time that the table is consistent with the hash for every word.
+    constexpr bool check_table(std::size_t k) noexcept
+    {
+        return k == static_cast<std::size_t>(keyword_e::hyphen) ||
+            (table[hash(texts[k], length(texts[k]))] == static_cast<keyword_e>(k) && check_table(k + 1));
+    }
+
+    static_assert(check_table(static_cast<std::size_t>(keyword_e::zero)), "the keyword hash is not a perfect hash");
+
+    /// Mask of the first letters of the words of the lexicon, bit `i` is the `i`-th letter of the alphabet.
+    constexpr std::uint32_t first_letters(std::size_t k) noexcept
+    {
+        return k == static_cast<std::size_t>(keyword_e::hyphen) ? 0 :
+            (std::uint32_t(1) << (texts[k][0] - 'a')) | first_letters(k + 1);
+    }
+
+    /// Length of the longest word of the lexicon, starting by keyword `k`, or `longest`.
+    constexpr std::size_t max_length(std::size_t k, std::size_t longest) noexcept
+    {
+        return k == static_cast<std::size_t>(keyword_e::count_) ? longest :
+            max_length(k + 1, length(texts[k]) > longest ? length(texts[k]) : longest);
+    }
+
+    constexpr std::uint32_t first_letter_mask = first_letters(static_cast<std::size_t>(keyword_e::zero));
+    constexpr std::size_t max_keyword_length = max_length(0, 0);
+
+    /// Returns whether `text` equals the lowercase `word`, ignoring the case of `text`.
+    bool equals_folded(absl::string_view text, absl::string_view word) noexcept
+    {
+        // as `word` only has lowercase letters, folding only matches the same letter
+        if (text.size() != word.size()) return false;
+        for (std::size_t i = 0; i != text.size(); ++i)
+            if ((text[i] | 0x20) != word[i]) return false;
+        return true;
+    }
+}
+
+namespace core {
+
+    keyword_e find_keyword(absl::string_view text) noexcept
+    {
+        // most words are rejected by their length or their first letter
+        if (text.empty() || text.size() > max_keyword_length) return keyword_e::none;
+        if (text.size() == 1 && text[0] == '-') return keyword_e::hyphen;
+
+        auto letter = static_cast<unsigned char>(text[0] | 0x20) - static_cast<unsigned>('a');
+        if (letter >= 26 || !(first_letter_mask >> letter & 1)) return keyword_e::none;
+
+        auto k = table[hash(text.data(), text.size())];
+        return equals_folded(text, keyword_text(k)) ? k : keyword_e::none;
+    }
+
+    absl::string_view keyword_text(keyword_e k) noexcept
+    {
+        return texts[static_cast<std::size_t>(k)];
+    }
+
+}
@@ -0,0 +1,78 @@
+#include "core/mapped_file.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define W2D_HAS_MMAP 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace core {
+
+    mapped_file_t::mapped_file_t() noexcept : data_(nullptr), size_(0), open_(false) {}
+
+    mapped_file_t::~mapped_file_t() {
+        close();
+    }
+
+#if defined(W2D_HAS_MMAP)
+
+    bool mapped_file_t::open(const std::string& path) noexcept {
+        close();
+
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+            ::close(fd);
+            return false;
+        }
+
+        // empty files cannot be mapped, but they are trivially represented
+        auto size = static_cast<std::size_t>(st.st_size);
+        if (size != 0) {
+            void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED) {
+                ::close(fd);
+                return false;
+            }
+            ::madvise(addr, size, MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(addr);
+        }
+
+        // the mapping remains valid after closing the file descriptor
+        ::close(fd);
+        size_ = size;
+        open_ = true;
+        return true;
+    }
+
+    void mapped_file_t::close() noexcept {
+        if (data_) ::munmap(const_cast<char*>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+        open_ = false;
+    }
+
+    bool mapped_file_t::is_regular_file(const std::string& path) noexcept {
+        struct stat st;
+        return ::stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+    }
+
+#else
+
+    bool mapped_file_t::open(const std::string&) noexcept {
+        return false;
+    }
+
+    void mapped_file_t::close() noexcept {}
+
+    bool mapped_file_t::is_regular_file(const std::string&) noexcept {
+        return false;
+    }
+
+#endif
+
+}
@@ -0,0 +1,90 @@
+#include "core/output.h"
+
+#include <ostream>
+#include <algorithm>
+
+namespace {
+
+    /// Decimal digits of the numbers from 0 to 99, two characters each.
+    const char digit_pairs[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+    /// Returns the number of decimal digits of `n`.
+    std::size_t count_digits(std::uint64_t n) noexcept
+    {
+        std::size_t digits = 1;
+        for (;;) {
+            if (n < 10) return digits;
+            if (n < 100) return digits + 1;
+            if (n < 1000) return digits + 2;
+            if (n < 10000) return digits + 3;
+            n /= 10000;
+            digits += 4;
+        }
+    }
+}
+
+namespace core {
+
+    constexpr std::size_t output_buffer_t::default_block_size;
+
+    std::size_t format_uint(std::uint64_t n, char* out) noexcept
+    {
+        // fill the digits backwards, two at a time
+        auto size = count_digits(n);
+        auto p = out + size;
+        while (n >= 100) {
+            auto pair = static_cast<std::size_t>(n % 100) * 2;
+            n /= 100;
+            *--p = digit_pairs[pair + 1];
+            *--p = digit_pairs[pair];
+        }
+        if (n >= 10) {
+            auto pair = static_cast<std::size_t>(n) * 2;
+            *--p = digit_pairs[pair + 1];
+            *--p = digit_pairs[pair];
+        }
+        else {
+            *--p = static_cast<char>('0' + n);
+        }
+        return size;
+    }
+
+    output_buffer_t::output_buffer_t(std::ostream& os, std::size_t block_size) noexcept :
+        os_(&os), block_(std::max(block_size, max_uint_digits)), size_(0)
+    {}
+
+    output_buffer_t::~output_buffer_t()
+    {
+        flush();
+    }
+
+    void output_buffer_t::flush() noexcept
+    {
+        if (size_ == 0) return;
+        os_->write(block_.data(), static_cast<std::streamsize>(size_));
+        size_ = 0;
+    }
+
+    void output_buffer_t::write_large(absl::string_view text) noexcept
+    {
+        // texts as large as the block are not worth copying
+        flush();
+        if (text.size() >= block_.size()) {
+            os_->write(text.data(), static_cast<std::streamsize>(text.size()));
+            return;
+        }
+        std::memcpy(block_.data(), text.data(), text.size());
+        size_ = text.size();
+    }
+
+}
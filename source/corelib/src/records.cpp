@@ -0,0 +1,256 @@
+#include "core/records.h"
+#include "core/scheduler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <ostream>
+
+namespace {
+    using namespace core;
+
+    /// Returns the first `c` in [first, last), or `last` if there is none.
+    const char* find_char(const char* first, const char* last, char c) noexcept
+    {
+        auto p = std::memchr(first, c, static_cast<std::size_t>(last - first));
+        return p ? static_cast<const char*>(p) : last;
+    }
+
+    /// Returns the closing quote of the JSON string whose contents start at `first`, or `last` if there is none.
+    const char* json_string_end(const char* first, const char* last) noexcept
+    {
+        for (auto p = first;;) {
+            auto quote = find_char(p, last, '"');
+            if (quote == last) return last;
+
+            // the quote is escaped if it follows an odd number of backslashes
+            auto escapes = quote;
+            while (escapes != p && escapes[-1] == '\\') --escapes;
+            if ((quote - escapes) % 2 == 0) return quote;
+            p = quote + 1;
+        }
+    }
+
+    /// Converts `in` into `out`, without collecting stats.
+    std::size_t convert_text(converter_t& converter, absl::string_view in, char* out, null_stats_t&) noexcept
+    {
+        return converter.convert(in, out);
+    }
+
+    /// Converts `in` into `out`, collecting stats.
+    std::size_t convert_text(converter_t& converter, absl::string_view in, char* out, stats_t& stats) noexcept
+    {
+        return converter.convert(in, out, stats);
+    }
+}
+
+namespace core {
+
+    record_converter_t::record_converter_t(const record_fields_t& fields) noexcept :
+        fields_(&fields)
+    {
+        for (auto column : fields.columns) {
+            if (column >= columns_.size()) columns_.resize(column + 1, false);
+            columns_[column] = true;
+        }
+    }
+
+    void record_converter_t::convert(absl::string_view in, std::string& out) noexcept
+    {
+        null_stats_t none;
+        convert_records(in, out, none);
+    }
+
+    void record_converter_t::convert(absl::string_view in, std::string& out, stats_t& stats) noexcept
+    {
+        convert_records(in, out, stats);
+    }
+
+    template<typename Stats>
+    void record_converter_t::convert_records(absl::string_view in, std::string& out, Stats& stats) noexcept
+    {
+        out.clear();
+        auto p = in.data();
+        auto last = in.data() + in.size();
+        while (p != last) {
+            if (fields_->format == record_format_e::jsonl) p = convert_json(p, last, out, stats);
+            else                                           p = convert_separated(p, last, out, stats);
+        }
+    }
+
+    template<typename Stats>
+    void record_converter_t::convert_field(absl::string_view field, std::string& out, Stats& stats) noexcept
+    {
+        // the converted field is never larger than the field, so it is written in place
+        auto pos = out.size();
+        out.resize(pos + field.size());
+        out.resize(pos + convert_text(converter_, field, &out[pos], stats));
+    }
+
+    template<typename Stats>
+    const char* record_converter_t::convert_separated(const char* first, const char* last, std::string& out, Stats& stats) noexcept
+    {
+        const bool quotes = fields_->format == record_format_e::csv;
+        const char delimiter = quotes ? ',' : '\t';
+
+        // text from `copied` on has not been written to `out` yet
+        auto copied = first;
+        auto eol = find_char(first, last, '\n');
+        auto p = first;
+        for (std::size_t column = 0;; ++column) {
+            const char* field_first;
+            const char* field_last;
+            if (quotes && p != eol && *p == '"') {
+                // doubled quotes are part of the field, which may span lines
+                auto quote = p + 1;
+                for (;;) {
+                    quote = find_char(quote, last, '"');
+                    if (quote + 1 < last && quote[1] == '"') quote += 2;
+                    else break;
+                }
+                field_first = p + 1;
+                field_last = quote;
+                p = quote == last ? last : quote + 1;
+                if (p > eol) eol = find_char(p, last, '\n');
+
+                // any text between the closing quote and the delimiter is kept as is
+                p = find_char(p, eol, delimiter);
+            }
+            else {
+                field_first = p;
+                field_last = p = find_char(p, eol, delimiter);
+            }
+
+            bool selected = columns_.empty() || (column < columns_.size() && columns_[column]);
+            if (selected && field_first != field_last) {
+                out.append(copied, field_first);
+                convert_field(absl::string_view(field_first, static_cast<std::size_t>(field_last - field_first)), out, stats);
+                copied = field_last;
+            }
+
+            if (p == eol) break;
+            ++p;
+        }
+
+        auto next = eol == last ? last : eol + 1;
+        out.append(copied, next);
+        return next;
+    }
+
+    template<typename Stats>
+    const char* record_converter_t::convert_json(const char* first, const char* last, std::string& out, Stats& stats) noexcept
+    {
+        // raw newlines are not valid within JSON values, so a record is a line
+        auto eol = find_char(first, last, '\n');
+        auto copied = first;
+
+        std::size_t depth = 0;
+        bool object = false;        // whether the record is an object
+        bool key_next = false;      // whether the next string at depth 1 is a key
+        bool selected = false;      // whether the next string at depth 1 is a converted value
+        for (auto p = first; p < eol; ++p) {
+            switch (*p) {
+            case '"': {
+                auto quote = json_string_end(p + 1, eol);
+                if (depth == 1 && object) {
+                    absl::string_view text(p + 1, static_cast<std::size_t>(quote - (p + 1)));
+                    if (key_next) {
+                        selected = selected_key(text);
+                        key_next = false;
+                    }
+                    else if (selected) {
+                        out.append(copied, text.data());
+                        convert_field(text, out, stats);
+                        copied = quote;
+                        selected = false;
+                    }
+                }
+                p = quote == eol ? eol - 1 : quote;
+                break;
+            }
+            case '{':
+            case '[':
+                if (depth == 0) object = *p == '{';
+                ++depth;
+                key_next = depth == 1 && object;
+                selected = false;
+                break;
+            case '}':
+            case ']':
+                if (depth != 0) --depth;
+                break;
+            case ',':
+                if (depth == 1) key_next = object;
+                selected = false;
+                break;
+            default:
+                break;
+            }
+        }
+
+        auto next = eol == last ? last : eol + 1;
+        out.append(copied, next);
+        return next;
+    }
+
+    bool record_converter_t::selected_key(absl::string_view key) const noexcept
+    {
+        auto& keys = fields_->keys;
+        return keys.empty() || std::find(keys.begin(), keys.end(), key) != keys.end();
+    }
+
+    std::size_t find_record_start(absl::string_view text, record_format_e format, std::size_t from, std::size_t pos) noexcept
+    {
+        if (pos <= from) return from;
+        if (pos >= text.size()) return text.size();
+
+        // a record starts after a newline that is not within a quoted field
+        auto last = text.data() + text.size();
+        auto p = text.data() + pos - 1;
+        bool quotes = format == record_format_e::csv;
+        bool quoted = quotes && std::count(text.data() + from, p, '"') % 2 != 0;
+        for (;;) {
+            auto eol = find_char(p, last, '\n');
+            if (eol == last) return text.size();
+            if (quotes && std::count(p, eol, '"') % 2 != 0) quoted = !quoted;
+            if (!quoted) return static_cast<std::size_t>(eol + 1 - text.data());
+            p = eol + 1;
+        }
+    }
+
+    void convert_records(absl::string_view in, std::ostream& os, const record_fields_t& fields, std::size_t jobs,
+                         std::size_t batch_size, stats_t* stats) noexcept
+    {
+        batch_size = std::max<std::size_t>(batch_size, 1);
+
+        // batches hold whole records, so they are converted independently
+        std::vector<absl::string_view> batches;
+        for (std::size_t pos = 0; pos != in.size();) {
+            auto end = find_record_start(in, fields.format, pos, std::min(pos + batch_size, in.size()));
+            batches.push_back(in.substr(pos, end - pos));
+            pos = end;
+        }
+
+        auto threads = task_threads(batches.size(), jobs);
+        std::deque<record_converter_t> converters;
+        for (std::size_t i = 0; i != threads; ++i) converters.emplace_back(fields);
+        std::vector<stats_t> worker_stats(threads);
+
+        // the writer thread only measures time, the counters come from the workers
+        stats_t writer_stats;
+
+        run_ordered_tasks(batches.size(), jobs, [&](std::size_t idx, std::size_t thread, std::string& out) {
+            if (stats) converters[thread].convert(batches[idx], out, worker_stats[thread]);
+            else       converters[thread].convert(batches[idx], out);
+        }, [&](std::size_t, std::string& output) {
+            auto timer = writer_stats.time(stage_e::write);
+            os.write(output.data(), static_cast<std::streamsize>(output.size()));
+        });
+
+        if (stats) {
+            for (auto& s : worker_stats) stats->merge(s);
+            stats->merge(writer_stats);
+        }
+    }
+
+}
@@ -0,0 +1,242 @@
+#include "core/rewrite.h"
+
+#include "core/digitize.h"
+#include "core/split.h"
+
+#include "absl/strings/string_view.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define W2D_HAS_MMAP 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    using namespace core;
+
+#if defined(W2D_HAS_MMAP)
+
+    /// Identifies a journal record, and the version of its layout.
+    const char journal_magic[8] = { 'w', '2', 'd', 'j', 'r', 'n', 'l', '1' };
+
+    /**
+     * Record of the journal, see rewrite_file().
+     *
+     * The converted text is [0, write_pos) and the original text that is not converted
+     * yet starts at read_pos. The original text of the segment being rewritten,
+     * [read_pos, segment_end), is saved along with the record. A record whose read_pos
+     * is the size of the file marks a complete rewrite, that may not be truncated yet.
+     *
+     * Consecutive records alternate between two slots, so that a record that is torn
+     * by a crash never destroys the previous one. The journal starts with the two
+     * records, followed by the segment of each slot.
+     *
+     * @note Records are written in the byte order of the machine, journals are not
+     *   meant to be moved between machines.
+     */
+    struct journal_record_t {
+        char magic[8];              //!< journal_magic.
+        std::uint64_t sequence;     //!< Number of the record, the last valid one is the current.
+        std::uint64_t file_size;    //!< Size of the original file.
+        std::uint64_t write_pos;    //!< End of the converted text.
+        std::uint64_t read_pos;     //!< Start of the original text that is not converted yet.
+        std::uint64_t segment_end;  //!< End of the segment being rewritten.
+        std::uint64_t checksum;     //!< FNV-1a of the fields above and of the segment.
+    };
+
+    /// Updates the FNV-1a `hash` with `size` bytes at `data`.
+    std::uint64_t fnv1a(const void* data, std::size_t size, std::uint64_t hash) noexcept
+    {
+        auto p = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i != size; ++i) hash = (hash ^ p[i]) * 1099511628211ull;
+        return hash;
+    }
+
+    /// Returns the checksum of `record` and of its `segment`.
+    std::uint64_t checksum(const journal_record_t& record, const char* segment) noexcept
+    {
+        auto hash = fnv1a(&record, offsetof(journal_record_t, checksum), 14695981039346656037ull);
+        return fnv1a(segment, static_cast<std::size_t>(record.segment_end - record.read_pos), hash);
+    }
+
+    /// Returns the offset of the segment of `slot` in the journal of a file of `file_size` bytes.
+    std::uint64_t segment_offset(std::uint64_t slot, std::uint64_t file_size) noexcept
+    {
+        return 2 * sizeof(journal_record_t) + slot * file_size;
+    }
+
+    /// Writes `size` bytes of `data` at `offset` of `fd`.
+    bool write_all(int fd, const char* data, std::size_t size, std::uint64_t offset) noexcept
+    {
+        while (size != 0) {
+            auto n = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            data += n;
+            size -= static_cast<std::size_t>(n);
+            offset += static_cast<std::uint64_t>(n);
+        }
+        return true;
+    }
+
+    /// Reads `size` bytes at `offset` of `fd` into `data`.
+    bool read_all(int fd, char* data, std::size_t size, std::uint64_t offset) noexcept
+    {
+        while (size != 0) {
+            auto n = ::pread(fd, data, size, static_cast<off_t>(offset));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            data += n;
+            size -= static_cast<std::size_t>(n);
+            offset += static_cast<std::uint64_t>(n);
+        }
+        return true;
+    }
+
+    /// Reads the last valid record of the journal `fd` and its segment, returns false if there is none.
+    bool read_record(int fd, journal_record_t& record, std::string& segment) noexcept
+    {
+        bool found = false;
+        for (std::uint64_t slot = 0; slot != 2; ++slot) {
+            journal_record_t r;
+            if (!read_all(fd, reinterpret_cast<char*>(&r), sizeof(r), slot * sizeof(r))) continue;
+            if (std::memcmp(r.magic, journal_magic, sizeof(journal_magic)) != 0) continue;
+            if (r.sequence % 2 != slot || r.read_pos > r.segment_end || r.segment_end > r.file_size) continue;
+            if (found && r.sequence < record.sequence) continue;
+
+            std::string s(static_cast<std::size_t>(r.segment_end - r.read_pos), '\0');
+            if (!s.empty() && !read_all(fd, &s[0], s.size(), segment_offset(slot, r.file_size))) continue;
+            if (checksum(r, s.data()) != r.checksum) continue;
+
+            record = r;
+            segment.swap(s);
+            found = true;
+        }
+        return found;
+    }
+
+    /// Writes `record` and its `segment` to the journal `fd`, and syncs it.
+    bool write_record(int fd, journal_record_t record, const char* segment) noexcept
+    {
+        std::memcpy(record.magic, journal_magic, sizeof(journal_magic));
+        record.checksum = checksum(record, segment);
+
+        auto slot = record.sequence % 2;
+        return write_all(fd, segment, static_cast<std::size_t>(record.segment_end - record.read_pos), segment_offset(slot, record.file_size)) &&
+               write_all(fd, reinterpret_cast<const char*>(&record), sizeof(record), slot * sizeof(record)) &&
+               ::fsync(fd) == 0;
+    }
+
+    /**
+     * Rewrites the original text of the mapped file `data` from `record.read_pos` on,
+     * writing the converted text from `record.write_pos`. If `journal` is not negative,
+     * each segment is journaled before it is rewritten.
+     */
+    bool rewrite_segments(char* data, journal_record_t& record, int journal, stats_t* stats, std::size_t segment_size) noexcept
+    {
+        auto page = static_cast<std::uint64_t>(::sysconf(_SC_PAGESIZE));
+        while (record.read_pos != record.file_size) {
+            auto rest = absl::string_view(data + record.read_pos, static_cast<std::size_t>(record.file_size - record.read_pos));
+            record.segment_end = journal < 0 ? record.file_size : record.read_pos + find_split_point(rest, segment_size);
+            if (journal >= 0 && !write_record(journal, record, data + record.read_pos)) return false;
+
+            auto segment = rest.substr(0, static_cast<std::size_t>(record.segment_end - record.read_pos));
+            auto size = convert_in_place(segment, data + record.write_pos, stats);
+
+            if (journal >= 0) {
+                // the segment must be on disk before the journal no longer has its original text
+                auto first = record.write_pos / page * page;
+                if (::msync(data + first, static_cast<std::size_t>(record.write_pos + size - first), MS_SYNC) != 0)
+                    return false;
+            }
+
+            record.write_pos += size;
+            record.read_pos = record.segment_end;
+            ++record.sequence;
+        }
+        return true;
+    }
+
+    /// Rewrites the file `fd`, resuming the rewrite of the journal `journal` if not negative.
+    bool rewrite(int fd, int journal, stats_t* stats, std::size_t segment_size) noexcept
+    {
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) return false;
+        auto size = static_cast<std::uint64_t>(st.st_size);
+
+        journal_record_t record = {};
+        record.file_size = size;
+
+        std::string segment;
+        if (journal >= 0 && read_record(journal, record, segment)) {
+            // an interrupted rewrite is resumed from the segment that was being rewritten,
+            // unless it was complete and only the truncation is missing
+            bool complete = record.read_pos == record.file_size;
+            if (size != record.file_size && !(complete && size == record.write_pos)) return false;
+            if (!complete && !write_all(fd, segment.data(), segment.size(), record.read_pos)) return false;
+            ++record.sequence;
+        }
+
+        if (record.read_pos != record.file_size) {
+            void* addr = ::mmap(nullptr, static_cast<std::size_t>(size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (addr == MAP_FAILED) return false;
+            ::madvise(addr, static_cast<std::size_t>(size), MADV_SEQUENTIAL);
+            bool ok = rewrite_segments(static_cast<char*>(addr), record, journal, stats, segment_size);
+            ::munmap(addr, static_cast<std::size_t>(size));
+            if (!ok) return false;
+
+            // the rewrite is complete once recorded, the truncation can be redone
+            record.segment_end = record.read_pos;
+            if (journal >= 0 && !write_record(journal, record, nullptr)) return false;
+        }
+
+        return ::ftruncate(fd, static_cast<off_t>(record.write_pos)) == 0 && ::fsync(fd) == 0;
+    }
+
+#endif
+}
+
+namespace core {
+
+#if defined(W2D_HAS_MMAP)
+
+    bool rewrite_file(const std::string& path, const std::string& journal, stats_t* stats, std::size_t segment_size) noexcept
+    {
+        int fd = ::open(path.c_str(), O_RDWR);
+        if (fd < 0) return false;
+
+        int journal_fd = -1;
+        if (!journal.empty()) {
+            journal_fd = ::open(journal.c_str(), O_RDWR | O_CREAT, 0666);
+            if (journal_fd < 0) {
+                ::close(fd);
+                return false;
+            }
+        }
+
+        bool ok = rewrite(fd, journal_fd, stats, std::max<std::size_t>(segment_size, 1));
+        ::close(fd);
+        if (journal_fd >= 0) {
+            ::close(journal_fd);
+            if (ok) ::unlink(journal.c_str());
+        }
+        return ok;
+    }
+
+#else
+
+    bool rewrite_file(const std::string&, const std::string&, stats_t*, std::size_t) noexcept {
+        return false;
+    }
+
+#endif
+
+}
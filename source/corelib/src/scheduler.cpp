@@ -0,0 +1,135 @@
+#include "core/scheduler.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    /// Tasks dealt to a thread, its owner takes them from the front and thieves from the back.
+    struct task_deque_t {
+        std::mutex mutex;
+        std::deque<std::size_t> tasks;
+    };
+
+    /// Takes the first task of `deque`, returns false if it is empty.
+    bool take_front(task_deque_t& deque, std::size_t& task) noexcept
+    {
+        std::lock_guard<std::mutex> lock(deque.mutex);
+        if (deque.tasks.empty()) return false;
+        task = deque.tasks.front();
+        deque.tasks.pop_front();
+        return true;
+    }
+
+    /// Takes the last task of `deque`, returns false if it is empty.
+    bool take_back(task_deque_t& deque, std::size_t& task) noexcept
+    {
+        std::lock_guard<std::mutex> lock(deque.mutex);
+        if (deque.tasks.empty()) return false;
+        task = deque.tasks.back();
+        deque.tasks.pop_back();
+        return true;
+    }
+}
+
+namespace core {
+
+    std::size_t task_threads(std::size_t count, std::size_t jobs) noexcept
+    {
+        if (jobs == 0) jobs = std::max(1u, std::thread::hardware_concurrency());
+        return std::max<std::size_t>(1, std::min(jobs, count));
+    }
+
+    void run_tasks(std::size_t count, std::size_t jobs, const std::function<void(std::size_t, std::size_t)>& task) noexcept
+    {
+        auto threads = task_threads(count, jobs);
+        std::vector<task_deque_t> deques(threads);
+        for (std::size_t i = 0; i != count; ++i)
+            deques[i % threads].tasks.push_back(i);
+
+        auto worker = [&](std::size_t self) {
+            for (;;) {
+                std::size_t next;
+                if (!take_front(deques[self], next)) {
+                    // no task is ever added, so once every deque is empty all of them are taken
+                    bool stolen = false;
+                    for (std::size_t i = 1; i != threads && !stolen; ++i)
+                        stolen = take_back(deques[(self + i) % threads], next);
+                    if (!stolen) return;
+                }
+                task(next, self);
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (std::size_t i = 1; i != threads; ++i)
+            pool.emplace_back(worker, i);
+        worker(0);
+        for (auto& thread : pool) thread.join();
+    }
+
+    void run_ordered_tasks(std::size_t count, std::size_t jobs,
+                           const std::function<void(std::size_t, std::size_t, std::string&)>& produce,
+                           const std::function<void(std::size_t, std::string&)>& consume) noexcept
+    {
+        // workers run the tasks in order, but never more than `window` tasks
+        // ahead of the ones already consumed, in order to bound memory usage
+        auto threads = task_threads(count, jobs);
+        const std::size_t window = 2 * threads;
+        std::vector<std::string> outputs(count);
+        std::vector<bool> done(count, false);
+        std::size_t next = 0, consumed = 0;
+        std::mutex mutex;
+        std::condition_variable cv;
+
+        auto worker = [&](std::size_t self) {
+            std::string out;
+            for (;;) {
+                std::size_t idx;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [&]{ return next == count || next < consumed + window; });
+                    if (next == count) return;
+                    idx = next++;
+                }
+
+                produce(idx, self, out);
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    outputs[idx].swap(out);
+                    done[idx] = true;
+                }
+                cv.notify_all();
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (std::size_t i = 0; i != threads; ++i)
+            pool.emplace_back(worker, i);
+
+        // consume the outputs in order as soon as they are available
+        for (std::size_t idx = 0; idx != count; ++idx) {
+            std::string output;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&]{ return done[idx]; });
+                output.swap(outputs[idx]);
+            }
+            consume(idx, output);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ++consumed;
+            }
+            cv.notify_all();
+        }
+
+        for (auto& thread : pool) thread.join();
+    }
+
+}
@@ -0,0 +1,85 @@
+#include "core/split.h"
+
+#include "core/char_class.h"
+#include "core/keyword.h"
+#include "core/grammar_variants.h"
+
+#include <algorithm>
+
+namespace {
+    using namespace core;
+
+    /// First letters, in either case, of the keywords that may start a textual number.
+    struct start_letters_t {
+        bool letter[256];
+
+        start_letters_t() noexcept : letter() {
+            for (std::size_t i = 0; i != static_cast<std::size_t>(keyword_e::count_); ++i) {
+                auto k = static_cast<keyword_e>(i);
+                if (!grammar_starts_number(k)) continue;
+                auto c = static_cast<unsigned char>(keyword_text(k)[0]);
+                letter[c | 0x20] = letter[c & ~0x20] = true;
+            }
+        }
+    };
+
+    const start_letters_t start_letters;
+}
+
+namespace core {
+
+    std::size_t find_split_point(absl::string_view text, std::size_t pos) noexcept
+    {
+        if (pos == 0 || pos >= text.size()) return std::min(pos, text.size());
+
+        // move to the start of the next token, which is where the category changes,
+        // `pos` may be in the middle of a multi-byte character
+        auto first = text.data(), last = text.data() + text.size();
+        token_scanner_t scanner;
+        pos = static_cast<std::size_t>(scanner.token_end(char_begin(first, first + pos - 1, last), last) - first);
+
+        // look for the first token that cannot be part of a match
+        for (auto p = first + pos; p != last;) {
+            auto end = scanner.token_end(p, last);
+            if (classify_char(p, last) != token_category_e::space &&
+                find_keyword(absl::string_view(p, static_cast<std::size_t>(end - p))) == keyword_e::none)
+                return static_cast<std::size_t>(p - first);
+            p = end;
+        }
+        return text.size();
+    }
+
+    std::size_t rfind_split_point(absl::string_view text) noexcept
+    {
+        // walk the tokens backwards up to the last one that cannot be part of a match,
+        // only spaces may be found between it and the first keyword after it
+        auto first = text.data();
+        auto keyword = text.size();
+        auto pos = text.data() + text.size();
+        while (pos != first) {
+            auto end = pos;
+            pos = token_begin(first, end);
+
+            if (classify_char(pos, end) == token_category_e::space) continue;
+            if (find_keyword(absl::string_view(pos, static_cast<std::size_t>(end - pos))) == keyword_e::none) return keyword;
+            keyword = static_cast<std::size_t>(pos - first);
+        }
+        return keyword;
+    }
+
+    std::size_t find_number_start(absl::string_view text, std::size_t pos) noexcept
+    {
+        auto first = text.data(), last = text.data() + text.size();
+        token_scanner_t scanner;
+        auto p = first + std::min(pos, text.size());
+        while ((p = scanner.next_alpha_token(first, p, last)) != last) {
+            auto end = scanner.token_end(p, last);
+            if (start_letters.letter[static_cast<unsigned char>(*p)] &&
+                grammar_starts_number(find_keyword(absl::string_view(p, static_cast<std::size_t>(end - p)))))
+                return static_cast<std::size_t>(p - first);
+            p = end;
+        }
+        return text.size();
+    }
+
+}
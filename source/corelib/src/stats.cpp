@@ -0,0 +1,110 @@
+#include "core/stats.h"
+
+#include <ostream>
+#include <iomanip>
+#include <algorithm>
+
+namespace core {
+
+    constexpr bool stats_t::enabled;
+    constexpr bool null_stats_t::enabled;
+    constexpr std::size_t stats_t::category_count;
+    constexpr std::size_t stats_t::rule_count;
+    constexpr std::size_t stats_t::stage_count;
+
+    const char* grammar_rule_name(grammar_rule_e rule) noexcept
+    {
+        static const char* const names[] = {
+            "CardNum", "AValue", "Millions", "MillionSfx", "Thousands", "ThousandSfx",
+            "Hundreds", "HundredSfx", "Below100", "SecDig", "Teens", "Digit"
+        };
+        static_assert(sizeof(names) / sizeof(names[0]) == static_cast<std::size_t>(grammar_rule_e::count_), "a name is needed for each rule");
+        return names[static_cast<std::size_t>(rule)];
+    }
+
+    const char* stage_name(stage_e stage) noexcept
+    {
+        switch (stage) {
+        case stage_e::read:     return "read";
+        case stage_e::tokenize: return "tokenize";
+        case stage_e::match:    return "match";
+        case stage_e::write:    return "write";
+        default:                return "unknown";
+        }
+    }
+
+    stage_timer_t::stage_timer_t(stats_t& stats, stage_e stage) noexcept :
+        stats_(&stats), stage_(stage), start_(std::chrono::steady_clock::now())
+    {}
+
+    stage_timer_t::stage_timer_t(stage_timer_t&& other) noexcept :
+        stats_(other.stats_), stage_(other.stage_), start_(other.start_)
+    {
+        other.stats_ = nullptr;
+    }
+
+    stage_timer_t::~stage_timer_t()
+    {
+        if (!stats_) return;
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_;
+        stats_->add_time(stage_, elapsed.count());
+    }
+
+    stats_t::stats_t() noexcept :
+        bytes_(0), skipped_(0), tokens_(), match_attempts_(0), matches_(0), matched_tokens_(0), examined_(), seconds_()
+    {}
+
+    void stats_t::merge(const stats_t& other) noexcept
+    {
+        bytes_ += other.bytes_;
+        skipped_ += other.skipped_;
+        for (std::size_t i = 0; i != category_count; ++i) tokens_[i] += other.tokens_[i];
+        match_attempts_ += other.match_attempts_;
+        matches_ += other.matches_;
+        matched_tokens_ += other.matched_tokens_;
+        for (std::size_t i = 0; i != rule_count; ++i) examined_[i] += other.examined_[i];
+        for (std::size_t i = 0; i != stage_count; ++i) seconds_[i] += other.seconds_[i];
+    }
+
+    std::uint64_t stats_t::examined() const noexcept
+    {
+        std::uint64_t total = 0;
+        for (auto n : examined_) total += n;
+        return total;
+    }
+
+    void print_stats(const stats_t& stats, std::ostream& os) noexcept
+    {
+        auto total = 0.0;
+        for (std::size_t i = 0; i != static_cast<std::size_t>(stage_e::count_); ++i)
+            total += stats.seconds(static_cast<stage_e>(i));
+
+        auto examined = stats.examined();
+        auto wasted = examined - std::min(examined, stats.matched_tokens());
+
+        os << "bytes:            " << stats.bytes() << " (" << stats.skipped() << " skipped without tokenizing)\n"
+           << "tokens:           space " << stats.tokens(token_category_e::space)
+           << ", alpha " << stats.tokens(token_category_e::alpha)
+           << ", other " << stats.tokens(token_category_e::other) << "\n"
+           << "match attempts:   " << stats.match_attempts() << "\n"
+           << "matches:          " << stats.matches() << " (" << stats.matched_tokens() << " tokens)\n"
+           << "examined tokens:  " << examined << " (" << wasted << " wasted in lookahead)\n";
+
+        for (std::size_t i = 0; i != static_cast<std::size_t>(grammar_rule_e::count_); ++i) {
+            auto rule = static_cast<grammar_rule_e>(i);
+            os << "  " << std::left << std::setw(16) << grammar_rule_name(rule) << std::right << stats.examined(rule) << "\n";
+        }
+
+        os << "wall time:\n";
+        for (std::size_t i = 0; i != static_cast<std::size_t>(stage_e::count_); ++i) {
+            auto stage = static_cast<stage_e>(i);
+            os << "  " << std::left << std::setw(16) << stage_name(stage) << std::right
+               << std::fixed << std::setprecision(6) << stats.seconds(stage) << " s\n";
+        }
+        os << "  " << std::left << std::setw(16) << "all stages" << std::right << total << " s\n";
+        if (total > 0) os << "throughput:       " << stats.bytes() / total / 1e6 << " MB/s\n";
+        os.unsetf(std::ios::floatfield | std::ios::adjustfield);
+        os << std::setprecision(6) << std::flush;
+    }
+
+}
@@ -1,32 +1,57 @@
 #include "core/token_stream.h"
+#include "core/char_class.h"
 
 #include <iostream>
 #include <cassert>
-#include <vector>
+#include <cstring>
 #include <string>
-#include <iomanip>
-#include <locale>
 #include <algorithm>
-#include <iterator>
 
 namespace {
     using namespace core;
-    token_category_e classify_char(char c, const std::locale& loc) noexcept {
-        if (std::isspace(c, loc)) return token_category_e::space;
-        if (std::isalpha(c, loc)) return token_category_e::alpha;
-        return token_category_e::other;
+
+    /// Returns the smallest power of two that is not less than `n`.
+    std::size_t ceil_pow2(std::size_t n) noexcept {
+        std::size_t p = 1;
+        while (p < n) p <<= 1;
+        return p;
     }
 }
 
 namespace core {
 
-    token_stream_t::token_stream_t(std::istream& is) noexcept : is_(&is), first_(0) {
-        (*is_) >> std::noskipws;
+    constexpr std::size_t token_stream_t::default_window;
+    constexpr std::size_t token_stream_t::block_size;
+
+    token_stream_t::token_stream_t(std::istream& is, std::size_t window) noexcept :
+        is_(&is), block_(block_size), offset_(0), carry_(0), stored_(0), first_(0), size_(0),
+        mask_(ceil_pow2(window) - 1), window_(mask_ + 1), records_(2 * window_.size())
+    {
+        get_token();
+    }
+
+    token_stream_t::token_stream_t(absl::string_view buffer, std::size_t window) noexcept :
+        is_(nullptr), buffer_(buffer), offset_(0), carry_(0), stored_(0), first_(0), size_(0),
+        mask_(ceil_pow2(window) - 1), window_(mask_ + 1), records_(2 * window_.size())
+    {
+        get_token();
+    }
+
+    void token_stream_t::reset(absl::string_view buffer) noexcept {
+        is_ = nullptr;
+        buffer_ = buffer;
+        offset_ = 0;
+        carry_ = 0;
+        first_ = 0;
+        size_ = 0;
+        scanner_.reset();
+        arena_.reset();
+        stored_ = 0;
         get_token();
     }
 
     bool token_stream_t::empty() const noexcept {
-        return token_type_.front() == token_category_e::end;
+        return record(first_).is_end();
     }
 
     token_stream_t::operator bool() const noexcept {
@@ -41,89 +66,132 @@ namespace core {
         return {};
     }
 
-    std::string& token_stream_t::token(std::size_t id) noexcept {
+    absl::string_view token_stream_t::token_raw(std::size_t id) const noexcept {
         assert(token_in_window(id));
-        return normalized_tokens_[id - first_];
+        return slot(id).raw;
     }
 
-    const std::string& token_stream_t::token(std::size_t id) const noexcept {
+    keyword_e token_stream_t::token_keyword(std::size_t id) const noexcept {
         assert(token_in_window(id));
-        return normalized_tokens_[id - first_];
+        return record(id).keyword;
     }
 
-    std::string& token_stream_t::token_raw(std::size_t id) noexcept {
+    token_category_e token_stream_t::token_category(std::size_t id) const noexcept {
         assert(token_in_window(id));
-        return tokens_[id - first_];
+        return record(id).category;
     }
 
-    const std::string& token_stream_t::token_raw(std::size_t id) const noexcept {
-        assert(token_in_window(id));
-        return tokens_[id - first_];
+    void token_stream_t::set_record(std::size_t id, token_record_t record) noexcept {
+        records_[id & mask_] = record;
+        records_[(id & mask_) + mask_ + 1] = record;
     }
 
-    token_category_e& token_stream_t::token_category(std::size_t id) noexcept {
-        assert(token_in_window(id));
-        return token_type_[id - first_];
+    bool token_stream_t::token_in_window(std::size_t id) const noexcept {
+        return id >= first_ && id - first_ < size_;
     }
 
-    const token_category_e& token_stream_t::token_category(std::size_t id) const noexcept {
-        assert(token_in_window(id));
-        return token_type_[id - first_];
+    std::size_t token_stream_t::last() noexcept {
+        return first_ + size_ - 1;
     }
 
-    bool token_stream_t::token_in_window(std::size_t id) const noexcept {
-        assert(tokens_.size() == normalized_tokens_.size() && tokens_.size() == token_type_.size());
-        return id >= first_ && id - first_ < tokens_.size();
-    }
+    token_stream_t::token_t& token_stream_t::push_token() noexcept {
+        if (size_ == window_.size()) grow_window();
 
-    std::size_t token_stream_t::last() noexcept {
-        return first_ + tokens_.size() - 1;
+        auto& token = slot(first_ + size_);
+        ++size_;
+
+        token.raw = {};
+        token.stored = false;
+        return token;
     }
 
-    void token_stream_t::get_token() noexcept {
-        char c;
+    void token_stream_t::grow_window() noexcept {
+        std::vector<token_t> window(window_.size() * 2);
+        std::vector<token_record_t> records(window.size() * 2);
+        auto mask = window.size() - 1;
 
-        // check if already at the end of the token stream
-        if (!token_type_.empty() && token_type_.back() == token_category_e::end) {
-            return;
+        for (auto id = first_; id != first_ + size_; ++id) {
+            window[id & mask] = slot(id);
+            records[id & mask] = records[(id & mask) + mask + 1] = record(id);
         }
 
-        // if we cannot obtain any new character, insert end token
-        if (!is_->get(c)) {
-            tokens_.emplace_back();
-            normalized_tokens_.emplace_back();
-            token_type_.push_back(token_category_e::end);
-            return;
+        window_.swap(window);
+        records_.swap(records);
+        mask_ = mask;
+    }
+
+    void token_stream_t::store_tokens() noexcept {
+        for (auto id = first_; id != first_ + size_; ++id) {
+            auto& token = slot(id);
+            if (token.stored || token.raw.empty()) continue;
+            token.raw = arena_.store(token.raw);
+            token.stored = true;
+            ++stored_;
         }
+    }
 
-        // classify the type of token from the type of the character following the input stream locale
-        auto loc = is_->getloc();
-        auto t = classify_char(c, loc);
+    bool token_stream_t::fill_buffer() noexcept {
+        if (!is_) return false;
 
-        tokens_.emplace_back();
-        normalized_tokens_.emplace_back();
-        token_type_.push_back(t);
+        // the block is about to be overwritten, but its stored tokens may still be accessed
+        store_tokens();
 
-        auto& token = tokens_.back();
-        token.push_back(c);
+        // a character split by the end of the previous block is completed by this one,
+        // there is none before the first block, whose buffer has no data
+        if (carry_) std::memmove(block_.data(), buffer_.data() + buffer_.size(), carry_);
+        auto request = block_.size() - carry_;
+        is_->read(block_.data() + carry_, static_cast<std::streamsize>(request));
+        auto read = static_cast<std::size_t>(is_->gcount());
+        auto size = carry_ + read;
 
-        // complete the token by inserting characters until one is of another class
-        while (is_->get(c)) {
-            if (t != classify_char(c, loc)) {
-                is_->unget();
-                break;
-            }
-            token.push_back(c);
+        // so that tokens never split a character, unless the stream ends with it
+        carry_ = read == request ? incomplete_char_size(block_.data(), block_.data() + size) : 0;
+        buffer_ = absl::string_view(block_.data(), size - carry_);
+        offset_ = 0;
+
+        // the cached classification refers to the previous contents of the block
+        scanner_.reset();
+        return !buffer_.empty();
+    }
+
+    void token_stream_t::get_token() noexcept {
+        // check if already at the end of the token stream
+        if (size_ != 0 && record(last()).is_end()) {
+            return;
         }
 
-        // normalize token, which means convert to lowercase for alpha tokens, and leave as is for the rest
-        if (t == token_category_e::alpha) {
-            auto& normalized_token = normalized_tokens_.back();
-            std::transform(token.begin(), token.end(), std::back_inserter(normalized_token), [&loc](char in){ return std::tolower(in, loc); });
+        // if there are no characters left, insert end token
+        if (offset_ == buffer_.size() && !fill_buffer()) {
+            push_token();
+            set_record(last(), { token_category_e::end, keyword_e::none });
+            return;
         }
-        else {
-            normalized_tokens_.back() = tokens_.back();
+
+        // the token spans all the following characters of the same category
+        auto& token = push_token();
+        auto first = buffer_.data() + offset_;
+        auto end = scanner_.token_end(first, buffer_.data() + buffer_.size());
+        offset_ = static_cast<std::size_t>(end - buffer_.data());
+        auto category = classify_char(first, end);
+
+        token.raw = absl::string_view(first, static_cast<std::size_t>(end - first));
+
+        // the token may continue in the next block, in which case it is already stored
+        // in the arena by the time the block is refilled, and it grows there
+        while (offset_ == buffer_.size() && fill_buffer()) {
+            first = buffer_.data();
+            end = buffer_.data() + buffer_.size();
+            if (classify_char(first, end) != category) break;
+
+            end = scanner_.token_end(first, end);
+            offset_ = static_cast<std::size_t>(end - first);
+            token.raw = arena_.append(token.raw, absl::string_view(first, static_cast<std::size_t>(end - first)));
         }
+
+        // resolve the keyword once, so that the grammar never compares text,
+        // keywords are found ignoring case so the text is never normalized
+        auto keyword = category != token_category_e::space ? find_keyword(token.raw) : keyword_e::none;
+        set_record(last(), { category, keyword });
     }
 
 
@@ -133,7 +201,7 @@ namespace core {
         if (token_in_window(id)) return id;
 
         auto idx = last();
-        while (token_category(idx) != token_category_e::end) {
+        while (!record(idx).is_end()) {
             get_token();
             ++idx;
             if (idx == id) return id;
@@ -142,24 +210,34 @@ namespace core {
         return idx;
     }
 
+    const token_record_t* token_stream_t::get_records(std::size_t id, std::size_t count) noexcept
+    {
+        // the tokens fit in the window once stored, so their records are contiguous
+        assert(count != 0);
+        get_token(id + count - 1);
+        return &records_[id & mask_];
+    }
+
     std::size_t token_stream_t::get_remove_token(std::size_t id) noexcept
     {
         assert(id >= first_);
 
         // get_token until id is in the window
         auto idx = std::min(last(), id);
-        while (idx != id && token_category(idx) != token_category_e::end) {
+        while (idx != id && !record(idx).is_end()) {
             get_token();
             ++idx;
         }
 
-        // all tokens up-to idx (non-inclusive) must be removed
-        tokens_.erase(tokens_.begin(), std::next(tokens_.begin(), idx - first_));
-        normalized_tokens_.erase(normalized_tokens_.begin(), std::next(normalized_tokens_.begin(), idx - first_));
-        token_type_.erase(token_type_.begin(), std::next(token_type_.begin(), idx - first_));
-
+        // all tokens up-to idx (non-inclusive) must be removed, their slots are reused afterwards,
+        // and so is the arena once none of the remaining tokens is stored in it
+        if (stored_ != 0) {
+            for (auto i = first_; i != idx; ++i) stored_ -= slot(i).stored;
+            if (stored_ == 0) arena_.reset();
+        }
+        size_ -= idx - first_;
         first_ = idx;
         assert(token_in_window(first_));
         return idx;
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,56 @@
+#include "unittest.h"
+
+#include "core/arena.h"
+
+#include <string>
+#include <vector>
+
+using namespace core;
+
+struct test_arena : ::testing::Test {};
+
+TEST(test_arena, conformance)
+{
+    arena_t arena(16);
+    ASSERT_EQ(arena.capacity(), 0u);
+    ASSERT_TRUE(arena.store("").empty());
+
+    // texts are copied and never move while stored
+    auto a = arena.store("hello");
+    auto b = arena.store("world");
+    ASSERT_EQ(a, "hello");
+    ASSERT_EQ(b, "world");
+    ASSERT_EQ(a.data() + a.size(), b.data());
+
+    // texts larger than a block get their own block
+    std::string large(100, 'x');
+    auto c = arena.store(large);
+    ASSERT_EQ(c, large);
+    ASSERT_EQ(a, "hello");
+
+    // the last text grows in place, or is moved along with the appended text
+    auto d = arena.store("ab");
+    auto e = arena.append(d, "cd");
+    ASSERT_EQ(e, "abcd");
+    ASSERT_EQ(e.data(), d.data());
+    for (int i = 0; i < 100; ++i) e = arena.append(e, "ef");
+    ASSERT_EQ(e.size(), 204u);
+    ASSERT_EQ(e.substr(0, 6), "abcdef");
+    ASSERT_EQ(c, large);
+}
+
+TEST(test_arena, reuse)
+{
+    // once reset, the same texts fit in the blocks of the previous round
+    arena_t arena(64);
+    std::vector<std::string> texts;
+    for (int i = 0; i < 50; ++i) texts.push_back(std::string(static_cast<std::size_t>(i * 7 % 90), 'a' + i % 26));
+
+    for (auto& text : texts) arena.store(text);
+    auto capacity = arena.capacity();
+    for (int round = 0; round < 10; ++round) {
+        arena.reset();
+        for (auto& text : texts) ASSERT_EQ(arena.store(text), text);
+        ASSERT_EQ(arena.capacity(), capacity);
+    }
+}
@@ -0,0 +1,103 @@
+#include "unittest.h"
+
+#include "core/char_class.h"
+
+#include "absl/strings/string_view.h"
+
+#include <string>
+#include <random>
+
+using namespace core;
+
+struct test_char_class : ::testing::Test {};
+
+TEST(test_char_class, kernels)
+{
+    std::mt19937 rng(42);
+    std::string text(char_class_block * 64, '\0');
+    for (auto& c : text) c = static_cast<char>(rng());
+
+    // all the supported kernels must agree with the scalar one
+    for (auto isa : { char_class_isa_e::sse2, char_class_isa_e::avx2, char_class_isa_e::avx512 }) {
+        if (!char_class_isa_supported(isa)) continue;
+        for (std::size_t i = 0; i < text.size(); i += char_class_block) {
+            auto expected = classify_block(text.data() + i, char_class_isa_e::scalar);
+            auto actual = classify_block(text.data() + i, isa);
+            ASSERT_EQ(expected.space, actual.space) << char_class_isa_name(isa);
+            ASSERT_EQ(expected.alpha, actual.alpha) << char_class_isa_name(isa);
+            ASSERT_EQ(expected.non_ascii, actual.non_ascii) << char_class_isa_name(isa);
+        }
+    }
+
+    auto masks = classify_block(u8"Ab \t\n\v\f\r@Z[`az{-0\x80\xff..............................................");
+    ASSERT_EQ(masks.space, 0xfcull);
+    ASSERT_EQ(masks.alpha, 0x3203ull);
+    ASSERT_EQ(masks.non_ascii, 0x60000ull);
+}
+
+TEST(test_char_class, utf8)
+{
+    auto category = [](absl::string_view c) { return classify_char(c.data(), c.data() + c.size()); };
+    auto size = [](absl::string_view c) { return char_size(c.data(), c.data() + c.size()); };
+
+    ASSERT_EQ(category(u8"\u00e9"), token_category_e::alpha);
+    ASSERT_EQ(category(u8"\u03a9"), token_category_e::alpha);
+    ASSERT_EQ(category(u8"\u0416"), token_category_e::alpha);
+    ASSERT_EQ(category(u8"\u6817"), token_category_e::alpha);
+    ASSERT_EQ(category(u8"\U00020000"), token_category_e::alpha);
+    ASSERT_EQ(category(u8"\u00a0"), token_category_e::space);
+    ASSERT_EQ(category(u8"\u2009"), token_category_e::space);
+    ASSERT_EQ(category(u8"\u3000"), token_category_e::space);
+    ASSERT_EQ(category(u8"\u00d7"), token_category_e::other);
+    ASSERT_EQ(category(u8"\u20ac"), token_category_e::other);
+    ASSERT_EQ(category(u8"\u3002"), token_category_e::other);
+    ASSERT_EQ(size(u8"\u00e9"), 2u);
+    ASSERT_EQ(size(u8"\u6817"), 3u);
+    ASSERT_EQ(size(u8"\U00020000"), 4u);
+
+    // bytes that are not well-formed are characters of their own
+    for (absl::string_view bad : { "\x80", "\xc0\xaf", "\xc3", "\xe0\x80\xaf", "\xed\xa0\x80", "\xf4\x90\x80\x80", "\xff" }) {
+        ASSERT_EQ(category(bad), token_category_e::other);
+        ASSERT_EQ(size(bad), 1u);
+    }
+
+    absl::string_view text = u8"ab\u00e9\u6817";
+    auto first = text.data(), last = text.data() + text.size();
+    ASSERT_EQ(char_begin(first, first + 3, last), first + 2);
+    ASSERT_EQ(char_begin(first, first + 6, last), first + 4);
+    ASSERT_EQ(char_begin(first + 3, first + 3, last), first + 3);
+    ASSERT_EQ(token_begin(first, last), first);
+    ASSERT_EQ(token_begin(first, first + 5), first + 4);
+
+    // a truncated character is incomplete if it is the start of a well-formed one
+    ASSERT_EQ(incomplete_char_size(first, last), 0u);
+    ASSERT_EQ(incomplete_char_size(first, last - 1), 2u);
+    ASSERT_EQ(incomplete_char_size(first, last - 2), 1u);
+    ASSERT_EQ(incomplete_char_size(first, first + 3), 1u);
+    ASSERT_EQ(incomplete_char_size(first, first + 2), 0u);
+    absl::string_view bad = "a\xe0\x80";
+    ASSERT_EQ(incomplete_char_size(bad.data(), bad.data() + bad.size()), 0u);
+}
+
+TEST(test_char_class, token_end)
+{
+    std::mt19937 rng(7);
+    const char* alphabet[] = { "a", "b", " ", "-", ".", "\n", u8"\u00e9", u8"\u00a0", u8"\u6817", u8"\u20ac", "\xff", "\xe6" };
+    std::string text;
+    while (text.size() < 1000) text += alphabet[rng() % (sizeof(alphabet) / sizeof(alphabet[0]))];
+    text.append(200, 'x');
+
+    // the scanner must find the same boundaries as a character by character search,
+    // even if multi-byte characters are split between blocks
+    token_scanner_t scanner;
+    auto last = text.data() + text.size();
+    for (auto first = text.data(); first != last;) {
+        auto t = classify_char(first, last);
+        auto expected = first + char_size(first, last);
+        while (expected != last && classify_char(expected, last) == t) expected += char_size(expected, last);
+        auto end = scanner.token_end(first, last);
+        ASSERT_EQ(end - text.data(), expected - text.data());
+        ASSERT_EQ(token_begin(text.data(), end), first);
+        first = end;
+    }
+}
@@ -0,0 +1,281 @@
+#include "unittest.h"
+
+#include "core/digitize.h"
+#include "core/split.h"
+#include "core/token_stream.h"
+
+#include <sstream>
+#include <string>
+
+using namespace core;
+
+struct test_digitize : ::testing::Test {};
+
+TEST(test_digitize, split_point)
+{
+    ASSERT_EQ(find_split_point("", 0), 0u);
+    ASSERT_EQ(find_split_point("one two", 0), 0u);
+    ASSERT_EQ(find_split_point("one two", 7), 7u);
+
+    // only text that cannot be part of a textual number splits
+    ASSERT_EQ(find_split_point("one hundred and two", 1), 19u);
+    ASSERT_EQ(find_split_point("one hundred, two", 1), 11u);
+    ASSERT_EQ(find_split_point("one hundred dogs", 5), 12u);
+    ASSERT_EQ(find_split_point("twenty-one dogs", 3), 11u);
+    ASSERT_EQ(find_split_point("dogs and cats", 2), 9u);
+
+    // the last split point is after the spaces that follow the last non-number token
+    ASSERT_EQ(rfind_split_point(""), 0u);
+    ASSERT_EQ(rfind_split_point("one two"), 0u);
+    ASSERT_EQ(rfind_split_point("  "), 2u);
+    ASSERT_EQ(rfind_split_point("  one"), 2u);
+    ASSERT_EQ(rfind_split_point("dogs"), 4u);
+    ASSERT_EQ(rfind_split_point("dogs, \n"), 7u);
+    ASSERT_EQ(rfind_split_point("one dogs. A hundred and"), 10u);
+    ASSERT_EQ(rfind_split_point("Twenty-One dogs -- seven"), 19u);
+}
+
+TEST(test_digitize, parallel)
+{
+    std::string text;
+    for (int i = 0; i < 200; ++i) {
+        text += "There are one hundred and twenty-three dogs, a thousand cats\n"
+                "and seven million\nthree birds. Twenty One Fourteen, nine. ";
+    }
+
+    std::ostringstream serial;
+    convert(text, serial);
+
+    for (std::size_t chunk_size : { 1, 7, 64, 1000, 100000 }) {
+        for (std::size_t jobs : { 0, 1, 2, 5 }) {
+            std::ostringstream parallel;
+            convert(text, parallel, jobs, chunk_size);
+            ASSERT_EQ(parallel.str(), serial.str()) << "jobs " << jobs << ", chunk size " << chunk_size;
+        }
+    }
+}
+
+TEST(test_digitize, pipelined)
+{
+    // several blocks, so that chunks are split while the blocks are being read
+    std::string text;
+    for (int i = 0; i < 3000; ++i) {
+        text += "There are one hundred and twenty-three dogs, a thousand cats\n"
+                "and seven million\nthree birds. Twenty One Fourteen, nine. ";
+    }
+    // a long textual number spans several blocks, as there is no split point in it
+    for (int i = 0; i < 20000; ++i) text += "one two ";
+    text += "end";
+
+    std::ostringstream serial;
+    convert(text, serial);
+
+    for (std::size_t queue_depth : { 1, 2, 8 }) {
+        std::istringstream in(text);
+        std::ostringstream pipelined;
+        convert_pipelined(in, pipelined, queue_depth);
+        ASSERT_EQ(pipelined.str(), serial.str()) << "queue depth " << queue_depth;
+    }
+
+    std::istringstream empty;
+    std::ostringstream out;
+    convert_pipelined(empty, out);
+    ASSERT_EQ(out.str(), "");
+}
+
+TEST(test_digitize, converter)
+{
+    converter_t converter;
+    std::string out;
+
+    // the output is replaced on every call, and the converter can be reused
+    // for texts of any size
+    converter.convert("forty-two dogs", out);
+    ASSERT_EQ(out, "42 dogs");
+    converter.convert("", out);
+    ASSERT_EQ(out, "");
+
+    std::string text;
+    for (int i = 0; i < 100; ++i) text += "one two three hundred and four, ";
+    std::ostringstream expected;
+    convert(text, expected);
+    converter.convert(text, out);
+    ASSERT_EQ(out, expected.str());
+
+    converter.convert("A million\nthree", out);
+    ASSERT_EQ(out, "\n1000003");
+}
+
+TEST(test_digitize, stats)
+{
+    std::string text = "one hundred and two dogs, a cat.\n";
+
+    stats_t stats;
+    std::ostringstream out;
+    convert(text, out, &stats);
+    ASSERT_EQ(out.str(), "102 dogs, a cat.\n");
+
+    // only "one hundred and two " and "a " may be part of a textual number, the rest is skipped
+    ASSERT_EQ(stats.bytes(), text.size());
+    ASSERT_EQ(stats.skipped(), 11u);
+    ASSERT_EQ(stats.tokens(token_category_e::alpha), 5u);
+    ASSERT_EQ(stats.tokens(token_category_e::space), 5u);
+    ASSERT_EQ(stats.tokens(token_category_e::other), 0u);
+    ASSERT_EQ(stats.matches(), 1u);
+    ASSERT_EQ(stats.matched_tokens(), 7u);
+    ASSERT_EQ(stats.match_attempts(), 4u);
+    ASSERT_GE(stats.examined(), stats.matched_tokens());
+
+    // the parallel conversion adds up the counters of every thread
+    stats_t parallel;
+    std::string texts;
+    for (int i = 0; i < 100; ++i) texts += text;
+    convert(texts, out, 4, 64, &parallel);
+    ASSERT_EQ(parallel.bytes(), texts.size());
+    ASSERT_EQ(parallel.matches(), 100u);
+}
+
+TEST(test_digitize, number_start)
+{
+    ASSERT_EQ(find_number_start("", 0), 0u);
+    ASSERT_EQ(find_number_start("dogs and cats", 0), 13u);
+    ASSERT_EQ(find_number_start("one", 0), 0u);
+    ASSERT_EQ(find_number_start("one two", 3), 4u);
+
+    // only whole words that start the grammar, in any case
+    ASSERT_EQ(find_number_start("someone, hundred - and Twenty", 0), 23u);
+    ASSERT_EQ(find_number_start("the zebra at A dog", 0), 13u);
+    ASSERT_EQ(find_number_start("caf\xc3\xa9one ZERO", 0), 9u);
+    ASSERT_EQ(find_number_start("\xc2\xa0nine", 0), 2u);
+
+    // the words are found across blocks of the classification kernels
+    std::string text(1000, '.');
+    text += "x Eleven";
+    ASSERT_EQ(find_number_start(text, 0), 1002u);
+    text.replace(62, 4, "a bc");
+    ASSERT_EQ(find_number_start(text, 0), 62u);
+    ASSERT_EQ(find_number_start(text, 63), 1002u);
+}
+
+TEST(test_digitize, push)
+{
+    std::string text;
+    for (int i = 0; i < 50; ++i) {
+        text += "There are one hundred and twenty-three dogs, a thousand cats\n"
+                "and seven million\nthree birds. Twenty One Fourteen, nine. ";
+    }
+    for (int i = 0; i < 100; ++i) text += "one two ";
+
+    std::ostringstream expected;
+    convert(text, expected);
+
+    // chunks split tokens and textual numbers anywhere
+    push_converter_t converter;
+    for (std::size_t chunk_size : { 1, 2, 7, 64, 1000, 100000 }) {
+        std::string result, out;
+        for (std::size_t pos = 0; pos < text.size(); pos += chunk_size) {
+            converter.feed(absl::string_view(text).substr(pos, chunk_size), out);
+            result += out;
+        }
+        converter.finish(out);
+        result += out;
+        ASSERT_EQ(result, expected.str()) << "chunk size " << chunk_size;
+    }
+
+    // output is only given once it is final
+    std::string out;
+    converter.feed("one hundred and", out);
+    ASSERT_EQ(out, "");
+    converter.feed(" seven", out);
+    ASSERT_EQ(out, "");
+    converter.finish(out);
+    ASSERT_EQ(out, "107");
+
+    std::string words;
+    for (int i = 0; i < 100; ++i) words += "dogs, ";
+    converter.feed(words, out);
+    ASSERT_FALSE(out.empty());
+    ASSERT_EQ(words.compare(0, out.size(), out), 0);
+    converter.finish(out);
+
+    // text that cannot start a textual number is given right away
+    converter.feed("a hundred dogs,", out);
+    ASSERT_EQ(out, "100 dogs");
+    converter.feed(" \n", out);
+    ASSERT_EQ(out, ", \n");
+    converter.feed("nine", out);
+    ASSERT_EQ(out, "");
+    converter.finish(out);
+    ASSERT_EQ(out, "9");
+}
+
+TEST(test_digitize, utf8)
+{
+    // letters of other scripts are words, and unicode spaces separate number words
+    std::ostringstream os;
+    convert(u8"caf\u00e9 one\u00a0hundred\u2009and two \u6817\u6797 one\u00e9", os);
+    ASSERT_EQ(os.str(), u8"caf\u00e9 102 \u6817\u6797 one\u00e9");
+
+    // characters split between blocks or chunks are not split into tokens
+    std::string prefix(token_stream_t::block_size - 5, 'a');
+    std::string text = prefix + u8" one\u00a0hundred \u00e9\u00e9 two";
+    for (std::size_t offset : { 0, 1, 2, 3, 4, 5 }) {
+        auto input = text.substr(offset);
+        std::istringstream is(input);
+        std::ostringstream streamed, pipelined;
+        convert(is, streamed);
+        std::istringstream pipelined_is(input);
+        convert_pipelined(pipelined_is, pipelined);
+        auto expected = prefix.substr(offset) + u8" 100 \u00e9\u00e9 2";
+        ASSERT_EQ(streamed.str(), expected) << "offset " << offset;
+        ASSERT_EQ(pipelined.str(), expected) << "offset " << offset;
+    }
+
+    push_converter_t converter;
+    std::string result, out;
+    for (auto chunk : { "one\xc2", "\xa0hundred \xc3", "\xa9", "\xc3\xa9 dogs" }) {
+        converter.feed(chunk, out);
+        result += out;
+    }
+    converter.finish(out);
+    result += out;
+    ASSERT_EQ(result, u8"100 \u00e9\u00e9 dogs");
+}
+
+TEST(test_digitize, in_place)
+{
+    // the shortest textual numbers for their digits, also spanning lines
+    std::string text = "a million, a\nmillion one\nmillion a hundred thousand ten\na\nhundred. ";
+    for (int i = 0; i < 200; ++i) {
+        text += "There are one hundred and twenty-three dogs, a thousand cats\n"
+                "and seven million\nthree birds. Twenty One Fourteen, nine. ";
+    }
+
+    std::ostringstream expected;
+    convert(text, expected);
+
+    auto buffer = text;
+    auto size = convert_in_place(buffer, &buffer[0]);
+    ASSERT_EQ(buffer.substr(0, size), expected.str());
+
+    std::string out(text.size(), '\0');
+    size = convert_in_place(text, &out[0]);
+    ASSERT_EQ(out.substr(0, size), expected.str());
+}
+
+TEST(test_digitize, interactive)
+{
+    std::string text;
+    for (int i = 0; i < 50; ++i) {
+        text += "There are one hundred and twenty-three dogs, a thousand cats\n"
+                "and seven million\nthree birds. Twenty One Fourteen, nine. ";
+    }
+
+    std::ostringstream expected;
+    convert(text, expected);
+
+    std::istringstream in(text);
+    std::ostringstream out;
+    convert_interactive(in, out);
+    ASSERT_EQ(out.str(), expected.str());
+}
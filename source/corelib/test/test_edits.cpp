@@ -0,0 +1,127 @@
+#include "unittest.h"
+
+#include "core/edits.h"
+#include "core/digitize.h"
+
+#include <sstream>
+#include <string>
+
+using namespace core;
+
+struct test_edits : ::testing::Test {};
+
+TEST(test_edits, jsonl)
+{
+    std::ostringstream edits;
+    std::istringstream in("I have forty-two dogs and one\nhundred cats.");
+    find_edits(in, edits, edit_format_e::jsonl);
+    ASSERT_EQ(edits.str(),
+              "{\"offset\":7,\"length\":9,\"value\":42}\n"
+              "{\"offset\":26,\"length\":11,\"value\":100,\"newline\":true}\n");
+
+    // the edits give the converted text, and whitespace within the script is allowed
+    std::istringstream script(edits.str() + "\n");
+    std::ostringstream out;
+    ASSERT_TRUE(apply_edits("I have forty-two dogs and one\nhundred cats.", script, out));
+    ASSERT_EQ(out.str(), "I have 42 dogs and \n100 cats.");
+
+    std::istringstream spaced("{ \"value\" : 7, \"offset\" : 2, \"length\" : 3, \"newline\" : false }\n");
+    std::ostringstream spaced_out;
+    ASSERT_TRUE(apply_edits("a one b", spaced, spaced_out));
+    ASSERT_EQ(spaced_out.str(), "a 7 b");
+}
+
+TEST(test_edits, binary)
+{
+    std::ostringstream edits;
+    std::istringstream in("twelve apples");
+    find_edits(in, edits, edit_format_e::binary);
+
+    auto script = edits.str();
+    ASSERT_EQ(script.size(), edit_magic.size() + edit_record_size);
+    ASSERT_EQ(script.substr(0, edit_magic.size()), std::string(edit_magic.data(), edit_magic.size()));
+    ASSERT_EQ(script.substr(edit_magic.size(), 8), std::string("\0\0\0\0\0\0\0\0", 8));
+    ASSERT_EQ(script.substr(edit_magic.size() + 8, 8), std::string("\6\0\0\0\0\0\0\0", 8));
+    ASSERT_EQ(script.substr(edit_magic.size() + 16, 8), std::string("\14\0\0\0\0\0\0\0", 8));
+
+    std::istringstream is(script);
+    edit_reader_t reader(is);
+    edit_t edit;
+    ASSERT_TRUE(reader.next(edit));
+    ASSERT_EQ(edit.offset, 0u);
+    ASSERT_EQ(edit.length, 6u);
+    ASSERT_EQ(edit.value, 12u);
+    ASSERT_FALSE(edit.newline);
+    ASSERT_FALSE(reader.next(edit));
+    ASSERT_FALSE(reader.failed());
+}
+
+TEST(test_edits, round_trip)
+{
+    std::string text;
+    for (int i = 0; i < 200; ++i) {
+        text += "There are one hundred and twenty-three dogs, a thousand cats\n"
+                "and seven million\nthree birds. Twenty One Fourteen, nine. ";
+    }
+
+    std::ostringstream converted;
+    convert(text, converted);
+
+    for (auto format : { edit_format_e::binary, edit_format_e::jsonl }) {
+        std::ostringstream serial;
+        std::istringstream is(text);
+        find_edits(is, serial, format);
+
+        // the parallel edits are the same, whatever the chunks
+        for (std::size_t chunk_size : { 1, 64, 100000 }) {
+            for (std::size_t jobs : { 1, 3 }) {
+                std::ostringstream parallel;
+                find_edits(text, parallel, format, jobs, chunk_size);
+                ASSERT_EQ(parallel.str(), serial.str()) << "jobs " << jobs << ", chunk size " << chunk_size;
+            }
+        }
+
+        // and applying them to the text, either in memory or in a stream, converts it
+        {
+            std::istringstream script(serial.str());
+            std::ostringstream out;
+            ASSERT_TRUE(apply_edits(text, script, out));
+            ASSERT_EQ(out.str(), converted.str());
+        }
+        {
+            std::istringstream script(serial.str()), original(text);
+            std::ostringstream out;
+            ASSERT_TRUE(apply_edits(original, script, out));
+            ASSERT_EQ(out.str(), converted.str());
+        }
+    }
+
+    // no textual numbers, no edits
+    std::ostringstream empty;
+    find_edits("dogs and cats", empty, edit_format_e::jsonl);
+    ASSERT_TRUE(empty.str().empty());
+}
+
+TEST(test_edits, malformed)
+{
+    auto apply = [](const std::string& text, const std::string& script) {
+        std::istringstream edits(script);
+        std::ostringstream out;
+        return apply_edits(text, edits, out);
+    };
+
+    ASSERT_TRUE(apply("one", ""));
+    ASSERT_TRUE(apply("one", std::string(edit_magic.data(), edit_magic.size())));
+
+    // edits out of order, overlapping or past the end of the text
+    ASSERT_FALSE(apply("one two", "{\"offset\":4,\"length\":3,\"value\":2}\n{\"offset\":0,\"length\":3,\"value\":1}\n"));
+    ASSERT_FALSE(apply("one two", "{\"offset\":0,\"length\":5,\"value\":1}\n{\"offset\":4,\"length\":3,\"value\":2}\n"));
+    ASSERT_FALSE(apply("one two", "{\"offset\":4,\"length\":4,\"value\":2}\n"));
+
+    // missing members, bad values or truncated records
+    ASSERT_FALSE(apply("one", "{\"offset\":0,\"length\":3}\n"));
+    ASSERT_FALSE(apply("one", "{\"offset\":-1,\"length\":3,\"value\":1}\n"));
+    ASSERT_FALSE(apply("one", "{\"offset\":0,\"length\":3,\"value\":1\n"));
+    ASSERT_FALSE(apply("one", "w2dedit0"));
+    ASSERT_FALSE(apply("one", std::string(edit_magic.data(), edit_magic.size()) + std::string(3, '\0')));
+}
@@ -4,6 +4,8 @@
 #include "core/grammar.h"
 
 #include <string>
+#include <sstream>
+#include <random>
 #include <cstdint>
 #include <utility>
 
@@ -13,36 +15,107 @@ using test_arg = std::pair<std::string, std::uint64_t>;
 
 struct test_grammar : ::testing::TestWithParam<test_arg> {};
 
+const grammar_engine_e engines[] = { grammar_engine_e::recursive_descent, grammar_engine_e::automaton };
+
 TEST_P(test_grammar, conformance)
 {
     auto param = GetParam();
-    std::stringstream ss{ param.first };
-    token_stream_t stream{ss};
-
-    auto it = stream.begin().look_ahead();
-    auto match = match_cardinal_number(it);
-    ASSERT_TRUE(match);
-    ASSERT_EQ(match.num, param.second);
-    ASSERT_TRUE((it + match.size)->is_end());
+    for (auto engine : engines) {
+        std::stringstream ss{ param.first };
+        token_stream_t stream{ss};
+
+        auto it = stream.begin().look_ahead();
+        auto match = match_cardinal_number(it, engine);
+        ASSERT_TRUE(match);
+        ASSERT_EQ(match.num, param.second);
+        ASSERT_TRUE((it + match.size)->is_end());
+    }
 }
 
 struct test_fail_grammar : ::testing::TestWithParam<std::string> {};
 TEST_P(test_fail_grammar, conformance)
 {
     auto param = GetParam();
-    std::stringstream ss{ param };
-    token_stream_t stream{ss};
+    for (auto engine : engines) {
+        std::stringstream ss{ param };
+        token_stream_t stream{ss};
 
-    auto it = stream.begin().look_ahead();
-    auto match = match_cardinal_number(it);
-    ASSERT_TRUE(!match || !(it + match.size)->is_end());
+        auto it = stream.begin().look_ahead();
+        auto match = match_cardinal_number(it, engine);
+        ASSERT_TRUE(!match || !(it + match.size)->is_end());
+    }
 }
 
+struct test_grammar_engines : ::testing::Test {};
+TEST(test_grammar_engines, conformance)
+{
+    // both engines must give identical matches at every token of random texts,
+    // which checks the generated rules against the hand-written automaton
+    const char* words[] = { "zero", "one", "seven", "ten", "fifteen", "twenty", "ninety", "hundred", "thousand",
+                            "million", "a", "and", "-", " ", " ", " ", "\n", ",", "word" };
+    std::mt19937 rng(1234);
+    for (int i = 0; i < 200; ++i) {
+        std::string text;
+        for (int j = 0; j < 200; ++j) text += words[rng() % (sizeof(words) / sizeof(words[0]))];
+
+        token_stream_t stream{ absl::string_view(text) };
+        for (auto it = stream.begin(); it != stream.end(); ++it) {
+            auto expected = match_cardinal_number(it.look_ahead(), grammar_engine_e::recursive_descent);
+            auto actual = match_cardinal_number(it.look_ahead(), grammar_engine_e::automaton);
+            ASSERT_EQ(expected.size, actual.size) << text;
+            ASSERT_EQ(expected.num, actual.num) << text;
+        }
+    }
+}
+
+struct test_grammar_variants : ::testing::Test {};
+TEST(test_grammar_variants, conformance)
+{
+    // matches the whole text with `variant`, or gives 0 tokens
+    auto match = [](std::string text, grammar_variant_e variant) -> match_t {
+        token_stream_t stream{ absl::string_view(text) };
+        auto it = stream.begin().look_ahead();
+        auto m = match_cardinal_number(it, variant);
+        if (!(it + m.size)->is_end()) return {};
+        return m;
+    };
+
+    ASSERT_EQ(match("one hundred and five", grammar_variant_e::british).num, 105u);
+    ASSERT_FALSE(match("one hundred five", grammar_variant_e::british));
+
+    ASSERT_EQ(match("one hundred and five", grammar_variant_e::american).num, 105u);
+    ASSERT_EQ(match("one hundred five", grammar_variant_e::american).num, 105u);
+    ASSERT_EQ(match("a hundred twenty", grammar_variant_e::american).num, 120u);
+    ASSERT_EQ(match("nine hundred ninety-nine thousand one hundred twenty-one", grammar_variant_e::american).num, 999121u);
+
+    ASSERT_EQ(match("one hundred thousand", grammar_variant_e::no_article).num, 100000u);
+    ASSERT_FALSE(match("a hundred", grammar_variant_e::no_article));
+    ASSERT_FALSE(match("a million", grammar_variant_e::no_article));
+
+    // the selected variant is the one matched when none is given
+    ASSERT_EQ(grammar_variant(), default_grammar_variant);
+    set_grammar_variant(grammar_variant_e::american);
+    {
+        std::string text = "two hundred two";
+        token_stream_t stream{ absl::string_view(text) };
+        ASSERT_EQ(match_cardinal_number(stream.begin().look_ahead()).num, 202u);
+    }
+    set_grammar_variant(default_grammar_variant);
+
+    // variants are found by their name
+    grammar_variant_e variant;
+    ASSERT_TRUE(find_grammar_variant("no_article", variant));
+    ASSERT_EQ(variant, grammar_variant_e::no_article);
+    ASSERT_STREQ(grammar_variant_name(variant), "no_article");
+    ASSERT_FALSE(find_grammar_variant("klingon", variant));
+}
 
 INSTANTIATE_TEST_SUITE_P(, test_grammar, ::testing::Values(
 test_arg{"zero", 0},
 test_arg{"one", 1},
 test_arg{"eleven", 11},
+test_arg{"fourteen", 14},
+test_arg{"fifteen", 15},
 test_arg{"fifty", 50},
 test_arg{"one hundred", 100},
 test_arg{"one thousand", 1000},
@@ -57,7 +130,12 @@ test_arg{"a thousand three hundred and eighty-five", 1385},
 test_arg{"a hundred thousand", 100000},
 test_arg{"a million three hundred and ninety-two", 1000392},
 test_arg{"a MiLlioN    three \n hundred and  ninety-two", 1000392},
-test_arg{"a hundred million", 100000000}
+test_arg{"a hundred million", 100000000},
+test_arg{"two thousand million", 2000000000},
+test_arg{"two thousand three million", 2003000000},
+test_arg{"a hundred thousand five hundred and sixteen", 100516},
+test_arg{"a million   ninety thousand   seven hundred   and eighty-one", 1090781},
+test_arg{"nine hundred and ninety-nine thousand nine hundred and ninety-nine million nine hundred and ninety-nine thousand nine hundred and ninety-nine", 999999999999}
 ));
 
 INSTANTIATE_TEST_SUITE_P(, test_fail_grammar, ::testing::Values(
@@ -69,5 +147,9 @@ INSTANTIATE_TEST_SUITE_P(, test_fail_grammar, ::testing::Values(
 "for-ty",
 "tw,o",
 "forty -two",
-"fifty five"
+"fifty five",
+"a",
+"a hundred and",
+"one hundred and two thousand thousand",
+"a thousand million"
 ));
@@ -0,0 +1,39 @@
+#include "unittest.h"
+
+#include "core/keyword.h"
+
+#include <string>
+
+using namespace core;
+
+struct test_keyword : ::testing::Test {};
+
+TEST(test_keyword, conformance)
+{
+    // every keyword is found from its own text
+    for (auto i = static_cast<int>(keyword_e::zero); i != static_cast<int>(keyword_e::count_); ++i) {
+        auto k = static_cast<keyword_e>(i);
+        ASSERT_EQ(find_keyword(keyword_text(k)), k) << std::string(keyword_text(k));
+    }
+
+    ASSERT_EQ(keyword_value(keyword_e::fourteen), 14u);
+    ASSERT_EQ(keyword_value(keyword_e::fifteen), 15u);
+    ASSERT_EQ(keyword_value(keyword_e::million), 1000000u);
+
+    // keywords are found ignoring case
+    ASSERT_EQ(find_keyword("One"), keyword_e::one);
+    ASSERT_EQ(find_keyword("THOUSAND"), keyword_e::thousand);
+    ASSERT_EQ(find_keyword("sEvEnTeEn"), keyword_e::seventeen);
+    ASSERT_EQ(find_keyword("A"), keyword_e::a);
+
+    ASSERT_EQ(find_keyword(""), keyword_e::none);
+    ASSERT_EQ(find_keyword("seventeens"), keyword_e::none);
+    ASSERT_EQ(find_keyword("Dogs"), keyword_e::none);
+    ASSERT_EQ(find_keyword("0ne"), keyword_e::none);
+    ASSERT_EQ(find_keyword("\xCEne"), keyword_e::none);
+    ASSERT_EQ(find_keyword("o\x0Ee"), keyword_e::none);
+    ASSERT_EQ(find_keyword("ones"), keyword_e::none);
+    ASSERT_EQ(find_keyword("tenth"), keyword_e::none);
+    ASSERT_EQ(find_keyword("an"), keyword_e::none);
+    ASSERT_EQ(find_keyword("--"), keyword_e::none);
+}
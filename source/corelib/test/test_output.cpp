@@ -0,0 +1,53 @@
+#include "unittest.h"
+
+#include "core/output.h"
+
+#include <sstream>
+#include <string>
+#include <cstdint>
+#include <limits>
+
+using namespace core;
+
+struct test_output : ::testing::Test {};
+
+TEST(test_output, format_uint)
+{
+    char digits[max_uint_digits];
+    auto format = [&](std::uint64_t n) { return std::string(digits, format_uint(n, digits)); };
+
+    ASSERT_EQ(format(0), "0");
+    ASSERT_EQ(format(7), "7");
+    ASSERT_EQ(format(10), "10");
+    ASSERT_EQ(format(99), "99");
+    ASSERT_EQ(format(100), "100");
+    ASSERT_EQ(format(1000), "1000");
+    ASSERT_EQ(format(10001), "10001");
+    ASSERT_EQ(format(100406857), "100406857");
+    ASSERT_EQ(format(std::numeric_limits<std::uint64_t>::max()), "18446744073709551615");
+
+    for (std::uint64_t n = 1; n < 10000000000000000000u; n = n * 10 + n % 7)
+        ASSERT_EQ(format(n), std::to_string(n));
+}
+
+TEST(test_output, buffer)
+{
+    std::ostringstream os;
+    std::string expected;
+    {
+        // writes smaller, equal and larger than the block
+        output_buffer_t out(os, 32);
+        for (int i = 0; i < 100; ++i) {
+            std::string text(static_cast<std::size_t>(i % 40), static_cast<char>('a' + i % 26));
+            out.write(text);
+            out.write(static_cast<std::uint64_t>(i) * 1000003u);
+            expected += text + std::to_string(i * 1000003);
+        }
+        out.flush();
+        ASSERT_EQ(os.str(), expected);
+
+        out.write("end");
+        expected += "end";
+    }
+    ASSERT_EQ(os.str(), expected);
+}
@@ -0,0 +1,85 @@
+#include "unittest.h"
+
+#include "core/records.h"
+
+#include <sstream>
+#include <string>
+
+using namespace core;
+
+struct test_records : ::testing::Test {};
+
+namespace {
+    std::string convert_all(const std::string& in, const record_fields_t& fields)
+    {
+        record_converter_t converter(fields);
+        std::string out;
+        converter.convert(in, out);
+        return out;
+    }
+}
+
+TEST(test_records, csv)
+{
+    record_fields_t fields{ record_format_e::csv, { 1, 3 }, {} };
+
+    // only the selected columns are converted, quotes and delimiters are kept
+    ASSERT_EQ(convert_all("one,two,three,four\n", fields), "one,2,three,4\n");
+    ASSERT_EQ(convert_all("one,\"two, three\",x,\"say \"\"five\"\"\"\r\n", fields), "one,\"2, 3\",x,\"say \"\"5\"\"\"\r\n");
+    ASSERT_EQ(convert_all("a,\"one\nhundred\",c,nine", fields), "a,\"\n100\",c,9");
+    ASSERT_EQ(convert_all(",,,\n\none", fields), ",,,\n\none");
+
+    // all the columns when none is selected
+    fields.columns.clear();
+    ASSERT_EQ(convert_all("one,two\nthree,four", fields), "1,2\n3,4");
+}
+
+TEST(test_records, tsv)
+{
+    record_fields_t fields{ record_format_e::tsv, { 0 }, {} };
+    ASSERT_EQ(convert_all("\"one\"\ttwo\nforty-two\tsix\n", fields), "\"1\"\ttwo\n42\tsix\n");
+}
+
+TEST(test_records, jsonl)
+{
+    record_fields_t fields{ record_format_e::jsonl, {}, { "text", "note" } };
+
+    // only the string values of the selected keys of top-level objects are converted
+    ASSERT_EQ(convert_all("{\"id\": \"one\", \"text\": \"forty-two dogs\"}\n", fields),
+              "{\"id\": \"one\", \"text\": \"42 dogs\"}\n");
+    ASSERT_EQ(convert_all("{\"text\":{\"text\":\"one\"},\"note\":[\"two\"],\"x\":1,\"note\":\"say \\\"forty-two\\\" three\"}", fields),
+              "{\"text\":{\"text\":\"one\"},\"note\":[\"two\"],\"x\":1,\"note\":\"say \\\"42\\\" 3\"}");
+    ASSERT_EQ(convert_all("[\"text\", \"one\"]\n\"text\"\n{\"text\": \"six\\\\\", \"note\": \"seven\"}\n", fields),
+              "[\"text\", \"one\"]\n\"text\"\n{\"text\": \"6\\\\\", \"note\": \"7\"}\n");
+
+    // all the values when no key is selected, but never the keys
+    fields.keys.clear();
+    ASSERT_EQ(convert_all("{\"one\": \"two\", \"three\": 4}", fields), "{\"one\": \"2\", \"three\": 4}");
+}
+
+TEST(test_records, batches)
+{
+    // newlines within quoted fields do not split records
+    std::string text = "a,\"b\nc\"\nd\n";
+    ASSERT_EQ(find_record_start(text, record_format_e::csv, 0, 0), 0u);
+    ASSERT_EQ(find_record_start(text, record_format_e::csv, 0, 3), 8u);
+    ASSERT_EQ(find_record_start(text, record_format_e::tsv, 0, 3), 5u);
+    ASSERT_EQ(find_record_start(text, record_format_e::csv, 0, 8), 8u);
+    ASSERT_EQ(find_record_start(text, record_format_e::csv, 0, 9), 10u);
+
+    std::string records;
+    for (int i = 0; i < 500; ++i)
+        records += "one,\"two\nhundred, and three\",forty-two\nseven,\"\"\"a\"\" thousand\",x\n";
+    record_fields_t fields{ record_format_e::csv, { 1 }, {} };
+    auto expected = convert_all(records, fields);
+
+    for (std::size_t jobs : { 1, 3 }) {
+        for (std::size_t batch_size : { 1, 7, 1000 }) {
+            std::ostringstream os;
+            stats_t stats;
+            convert_records(records, os, fields, jobs, batch_size, &stats);
+            ASSERT_EQ(os.str(), expected) << "jobs " << jobs << ", batch size " << batch_size;
+            ASSERT_EQ(stats.matches(), 1000u);
+        }
+    }
+}
@@ -0,0 +1,133 @@
+#include "unittest.h"
+
+#include "core/rewrite.h"
+#include "core/digitize.h"
+
+#include <sstream>
+#include <fstream>
+#include <string>
+#include <cstdio>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace core;
+
+struct test_rewrite : ::testing::Test {};
+
+namespace {
+    std::string read_file(const char* path)
+    {
+        std::stringstream contents;
+        std::ifstream file{ path, std::ios::binary };
+        contents << file.rdbuf();
+        return contents.str();
+    }
+
+    void write_file(const char* path, const std::string& contents)
+    {
+        std::ofstream{ path, std::ios::binary } << contents;
+    }
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+
+TEST(test_rewrite, conformance)
+{
+    auto fname = "test_Zp4nWc2hLe";
+    auto journal = "test_Zp4nWc2hLe.journal";
+    std::remove(fname);
+    std::remove(journal);
+
+    std::string text;
+    for (int i = 0; i < 200; ++i) {
+        text += "There are one hundred and twenty-three dogs, a thousand cats\n"
+                "and seven million\nthree birds. Twenty One Fourteen, nine. ";
+    }
+    std::ostringstream expected;
+    convert(text, expected);
+
+    ASSERT_FALSE(rewrite_file(fname));
+
+    // without a journal
+    write_file(fname, text);
+    ASSERT_TRUE(rewrite_file(fname));
+    ASSERT_EQ(read_file(fname), expected.str());
+
+    // with a journal, which is removed once complete
+    for (std::size_t segment_size : { 1, 100, 1000000 }) {
+        write_file(fname, text);
+        ASSERT_TRUE(rewrite_file(fname, journal, nullptr, segment_size));
+        ASSERT_EQ(read_file(fname), expected.str()) << "segment size " << segment_size;
+        ASSERT_FALSE(std::ifstream{ journal }.is_open());
+    }
+
+    // empty files and journals without a valid record are fine
+    write_file(fname, "");
+    write_file(journal, "garbage");
+    ASSERT_TRUE(rewrite_file(fname, journal));
+    ASSERT_EQ(read_file(fname), "");
+
+    std::remove(fname);
+}
+
+TEST(test_rewrite, resume)
+{
+    auto fname = "test_Zp4nWc2hLf";
+    auto journal = "test_Zp4nWc2hLf.journal";
+    std::remove(fname);
+    std::remove(journal);
+
+    std::string text;
+    for (int i = 0; i < 2000; ++i) {
+        text += "There are one hundred and twenty-three dogs, a thousand cats\n"
+                "and seven million\nthree birds. Twenty One Fourteen, nine. ";
+    }
+    std::ostringstream expected;
+    convert(text, expected);
+
+    // the rewrite is killed at any point, and then resumed
+    for (int delay_us : { 0, 200, 1000, 5000, 20000 }) {
+        write_file(fname, text);
+        auto pid = ::fork();
+        ASSERT_GE(pid, 0);
+        if (pid == 0) {
+            rewrite_file(fname, journal, nullptr, 512);
+            ::_exit(0);
+        }
+        ::usleep(static_cast<useconds_t>(delay_us));
+        ::kill(pid, SIGKILL);
+        ::waitpid(pid, nullptr, 0);
+
+        ASSERT_TRUE(rewrite_file(fname, journal, nullptr, 512)) << "delay " << delay_us;
+        ASSERT_EQ(read_file(fname), expected.str()) << "delay " << delay_us;
+    }
+
+    // a journal of another file is rejected: a hard link keeps the journal of a
+    // complete rewrite once it is removed, so that it has valid records
+    auto leftover = "test_Zp4nWc2hLf.leftover";
+    std::remove(leftover);
+    write_file(fname, text);
+    write_file(journal, "");
+    ASSERT_EQ(::link(journal, leftover), 0);
+    ASSERT_TRUE(rewrite_file(fname, journal, nullptr, 512));
+    ASSERT_FALSE(std::ifstream{ journal }.is_open());
+    ASSERT_EQ(::rename(leftover, journal), 0);
+
+    write_file(fname, "one two");
+    ASSERT_FALSE(rewrite_file(fname, journal));
+    ASSERT_EQ(read_file(fname), "one two");
+
+    // while the file it was written for is taken as already rewritten
+    write_file(fname, expected.str());
+    ASSERT_TRUE(rewrite_file(fname, journal));
+    ASSERT_EQ(read_file(fname), expected.str());
+
+    std::remove(fname);
+    std::remove(journal);
+}
+
+#endif
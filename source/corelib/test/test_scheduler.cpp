@@ -0,0 +1,82 @@
+#include "unittest.h"
+
+#include "core/scheduler.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <string>
+#include <vector>
+
+using namespace core;
+
+struct test_scheduler : ::testing::Test {};
+
+TEST(test_scheduler, conformance)
+{
+    ASSERT_EQ(task_threads(0, 4), 1u);
+    ASSERT_EQ(task_threads(3, 4), 3u);
+    ASSERT_EQ(task_threads(10, 4), 4u);
+    ASSERT_GE(task_threads(10, 0), 1u);
+
+    // every task runs exactly once, on one of the threads
+    for (std::size_t count : { 0, 1, 3, 100 }) {
+        for (std::size_t jobs : { 0, 1, 2, 5 }) {
+            std::vector<std::atomic<int>> runs(count);
+            for (auto& r : runs) r = 0;
+            std::atomic<bool> valid_thread(true);
+            auto threads = task_threads(count, jobs);
+            run_tasks(count, jobs, [&](std::size_t task, std::size_t thread) {
+                ++runs[task];
+                if (thread >= threads) valid_thread = false;
+            });
+            for (auto& r : runs) ASSERT_EQ(r.load(), 1) << "count " << count << ", jobs " << jobs;
+            ASSERT_TRUE(valid_thread.load());
+        }
+    }
+}
+
+TEST(test_scheduler, stealing)
+{
+    // the first task only finishes once all the others are done, which requires the
+    // tasks dealt to its thread to be stolen by the other one
+    const std::size_t count = 20;
+    std::atomic<std::size_t> done(0);
+    std::atomic<bool> stolen(false);
+    run_tasks(count, 2, [&](std::size_t task, std::size_t) {
+        if (task == 0) {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            while (done != count - 1 && std::chrono::steady_clock::now() < deadline)
+                std::this_thread::yield();
+            stolen = done == count - 1;
+        }
+        ++done;
+    });
+    ASSERT_TRUE(stolen.load());
+    ASSERT_EQ(done.load(), count);
+}
+
+TEST(test_scheduler, ordered)
+{
+    // outputs are consumed in order, whatever the order in which the tasks finish
+    for (std::size_t count : { 0, 1, 3, 100 }) {
+        for (std::size_t jobs : { 0, 1, 2, 5 }) {
+            auto threads = task_threads(count, jobs);
+            std::atomic<bool> valid_thread(true);
+            std::string consumed;
+            run_ordered_tasks(count, jobs, [&](std::size_t task, std::size_t thread, std::string& out) {
+                if (thread >= threads) valid_thread = false;
+                if (task % 3 == 0) std::this_thread::sleep_for(std::chrono::microseconds(100));
+                out = std::to_string(task) + ",";
+            }, [&](std::size_t task, std::string& out) {
+                if (out != std::to_string(task) + ",") valid_thread = false;
+                consumed += out;
+            });
+
+            std::string expected;
+            for (std::size_t i = 0; i != count; ++i) expected += std::to_string(i) + ",";
+            ASSERT_EQ(consumed, expected) << "count " << count << ", jobs " << jobs;
+            ASSERT_TRUE(valid_thread.load());
+        }
+    }
+}
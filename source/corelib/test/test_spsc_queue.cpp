@@ -0,0 +1,39 @@
+#include "unittest.h"
+
+#include "core/spsc_queue.h"
+
+#include <thread>
+
+using namespace core;
+
+struct test_spsc_queue : ::testing::Test {};
+
+TEST(test_spsc_queue, conformance)
+{
+    spsc_queue_t<int> queue(3);
+    ASSERT_EQ(queue.capacity(), 3u);
+
+    // elements are popped in order, and the producer is blocked while the queue is full
+    const int count = 100000;
+    std::thread producer([&]() {
+        for (int i = 0; i < count; ++i) queue.push(i);
+        queue.close();
+    });
+
+    int value = -1;
+    for (int i = 0; i < count; ++i) {
+        ASSERT_TRUE(queue.pop(value));
+        ASSERT_EQ(value, i);
+    }
+    ASSERT_FALSE(queue.pop(value));
+    producer.join();
+
+    // a zero capacity still allows one element
+    spsc_queue_t<int> single(0);
+    ASSERT_EQ(single.capacity(), 1u);
+    single.push(42);
+    single.close();
+    ASSERT_TRUE(single.pop(value));
+    ASSERT_EQ(value, 42);
+    ASSERT_FALSE(single.pop(value));
+}
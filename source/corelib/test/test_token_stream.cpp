@@ -41,3 +41,100 @@ TEST(test_token_stream, conformance) {
 
 }
 
+
+TEST(test_token_stream, buffer) {
+    std::string text = "Abc \n 32%-_";
+    token_stream_t stream{ absl::string_view(text) };
+
+    ASSERT_TRUE(stream);
+
+    auto it = stream.begin();
+    ASSERT_TRUE((it.look_ahead() + 3)->is_end());
+
+    // tokens are views into the buffer, no text is copied
+    ASSERT_TRUE(it->is_alpha());
+    ASSERT_EQ(it->raw_str(), "Abc");
+    ASSERT_EQ(it->raw_str().data(), text.data());
+    ASSERT_EQ(it->keyword(), keyword_e::none);
+
+    ++it;
+    ASSERT_TRUE(it->is_space());
+    ASSERT_EQ(it->raw_str().data(), text.data() + 3);
+    ASSERT_EQ(it->raw_str(), " \n ");
+
+    ++it;
+    ASSERT_TRUE(it->is_other());
+    ASSERT_EQ(it->raw_str(), "32%-_");
+
+    ++it;
+    ASSERT_TRUE(stream.empty());
+    ASSERT_EQ(it->id(), 3);
+    ASSERT_TRUE(it->is_end());
+}
+
+TEST(test_token_stream, window) {
+    std::stringstream ss(u8"One two three four five six");
+    token_stream_t stream{ ss, 2 };
+
+    // looking ahead beyond the window grows it, keeping the stored tokens
+    auto it = stream.begin();
+    auto fwdit = it.look_ahead() + 10;
+    ASSERT_TRUE(fwdit->is_alpha());
+    ASSERT_EQ(fwdit->raw_str(), "six");
+    ASSERT_EQ(it->raw_str(), "One");
+    ASSERT_EQ(it->keyword(), keyword_e::one);
+    ASSERT_EQ((it.look_ahead() + 4)->keyword(), keyword_e::three);
+
+    // consumed slots are reused for the following tokens
+    it += 10;
+    ASSERT_EQ(it->raw_str(), "six");
+    ++it;
+    ASSERT_TRUE(it->is_end());
+    ASSERT_TRUE(stream.empty());
+}
+
+TEST(test_token_stream, blocks) {
+    // tokens that span blocks, and tokens looked ahead while a block is refilled
+    std::string text;
+    for (int i = 0; i < 3000; ++i) {
+        text += "one, two  three";
+        text += std::string(static_cast<std::size_t>(i % 97), i % 2 ? ' ' : 'x');
+    }
+    text += std::string(3 * token_stream_t::block_size, 'y');
+    text += " four";
+
+    token_stream_t expected{ absl::string_view(text) };
+    std::stringstream ss(text);
+    token_stream_t stream{ ss };
+
+    auto exp = expected.begin();
+    auto it = stream.begin();
+    for (; !exp->is_end(); ++exp, ++it) {
+        auto fwdexp = exp.look_ahead();
+        auto fwdit = it.look_ahead();
+        for (int i = 0; i < 50 && !fwdexp->is_end(); ++i, ++fwdexp, ++fwdit) {
+            ASSERT_EQ(fwdit->category(), fwdexp->category());
+            ASSERT_EQ(fwdit->raw_str(), fwdexp->raw_str());
+            ASSERT_EQ(fwdit->keyword(), fwdexp->keyword());
+        }
+    }
+    ASSERT_TRUE(it->is_end());
+}
+
+TEST(test_token_stream, records) {
+    // records are contiguous even when the window grows and wraps around
+    std::string text;
+    for (int i = 0; i < 200; ++i) text += "one-two,  thousand ";
+
+    token_stream_t stream{ absl::string_view(text), 4 };
+    auto it = stream.begin();
+    for (std::size_t count = 1; !it->is_end(); ++it, count = count % 40 + 1) {
+        auto records = it.look_ahead().records(count);
+        auto fwdit = it.look_ahead();
+        for (std::size_t i = 0; i < count; ++i, ++fwdit) {
+            ASSERT_EQ(records[i].category, fwdit->category());
+            ASSERT_EQ(records[i].keyword, fwdit->keyword());
+            if (records[i].is_end()) break;
+        }
+    }
+}
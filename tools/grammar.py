@@ -1,30 +1,30 @@
 from nltk.parse.generate import generate
 from nltk import CFG
+import os
 import random
+import sys
 
-grammar = CFG.fromstring("""
-    CardNum -> 'zero' | Millions | AValue
+import grammar_gen
 
-    Digit -> 'one' | 'two' | 'three' | 'four' | 'five' | 'six' | 'seven' | 'eight' | 'nine'
-    Teens ->  'ten' | 'eleven' | 'twelve'  | 'thirteen' | 'fourteen' | 'fifteen' | 'sixteen' | 'seventeen' | 'eighteen' | 'nineteen'
-    SecDig -> 'twenty' | 'thirty' | 'forty' | 'fifty' | 'sixty' | 'seventy' | 'eighty' | 'ninety'
-    Below100 -> Digit | Teens | SecDig | SecDig '-' Digit
+# the grammar description from which the matchers are generated, see grammar_gen.py
+path = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'source', 'corelib', 'grammar', 'cardinal.grammar')
+variant = sys.argv[1] if len(sys.argv) > 1 else 'british'
+with open(path) as f:
+    rules = grammar_gen.rules_in_order(grammar_gen.parse(f.read())[variant])
 
-    HundredSfx   -> 'hundred' | 'hundred and ' Below100
-    Hundreds     -> Below100 | Digit ' ' HundredSfx
 
-    ThousandSfx  -> 'thousand' | 'thousand ' Hundreds
-    Thousands    -> Hundreds | Hundreds ' ' ThousandSfx
+def production(rule):
+    alternatives = [' '.join("' '" if item.kind == 'space' else item.text() for item in alt.items)
+                    for alt in rule.alternatives]
+    return '%s -> %s' % (rule.name, ' | '.join(alternatives))
 
-    MillionSfx   -> 'million' | 'million ' Thousands
-    Millions     -> Thousands | Thousands ' ' MillionSfx
 
-    AValue       -> 'a ' HundredSfx | 'a ' ThousandSfx | 'a hundred ' ThousandSfx | 'a ' MillionSfx | 'a hundred ' MillionSfx
-""")
+# the start symbol is the first rule, CardNum, which is the last in order
+grammar = CFG.fromstring('\n'.join(production(rule) for rule in reversed(rules)))
 
 p = 0.3
 d = 0.1
 for i, sentence in enumerate(generate(grammar)):
     if random.uniform(0,1) < p:
         print(''.join(sentence))
-        p = p * d
\ No newline at end of file
+        p = p * d
@@ -0,0 +1,480 @@
+"""Generates the matchers of the grammars described in source/corelib/grammar/cardinal.grammar.
+
+The build runs it to generate two files:
+
+  - a header, core/grammar_variants.h, with grammar_variant_e and the constants
+    that depend on the grammars;
+  - a source, grammar_rules.inc, included by grammar.cpp, with a function template
+    per rule and variant, whose alternatives are factored by their common prefix.
+
+Only the standard library is used, so that the build has no other dependency.
+"""
+
+import argparse
+import re
+import sys
+from collections import OrderedDict
+
+START_RULE = 'CardNum'
+HEADER_GUARD = 'INCLUDE_GUARD__GRAMMAR_VARIANTS_H__GUID_8d41c7b2e95a4f36a0d2b6e1f3c97a54'
+
+
+class GrammarError(Exception):
+    pass
+
+
+class Item(object):
+    """An item of an alternative: a keyword, a Space or another rule."""
+
+    def __init__(self, kind, name):
+        self.kind = kind    # 'keyword', 'space' or 'rule'
+        self.name = name
+
+    def key(self):
+        return (self.kind, self.name)
+
+    def text(self):
+        if self.kind == 'keyword':
+            return "'%s'" % self.name
+        if self.kind == 'space':
+            return '_'
+        return self.name
+
+    def enumerator(self):
+        """Returns the keyword_e enumerator of a keyword."""
+        if self.name == '-':
+            return 'keyword_e::hyphen'
+        if self.name == 'and':
+            return 'keyword_e::and_'
+        return 'keyword_e::' + self.name
+
+
+class Alternative(object):
+    def __init__(self, items, expr, line):
+        self.items = items
+        self.expr = expr    # value expression, None for the value of the first item
+        self.line = line
+
+    def text(self):
+        text = ' '.join(item.text() for item in self.items)
+        return text + (' = ' + self.expr if self.expr is not None else '')
+
+
+class Rule(object):
+    def __init__(self, name, line):
+        self.name = name
+        self.alternatives = []
+        self.line = line
+
+    def text(self):
+        return '%s -> %s' % (self.name, ' | '.join(alt.text() for alt in self.alternatives))
+
+
+class Grammar(object):
+    def __init__(self, name, base, doc):
+        self.name = name
+        self.base = base
+        self.doc = doc
+        self.rules = OrderedDict()  # all the rules, including those of the base
+
+
+TOKEN_RE = re.compile(r"\s*(?:'([^']*)'|(_)|([A-Za-z][A-Za-z0-9]*))")
+EXPR_RE = re.compile(r'^[0-9$+*() ]+$')
+
+
+def parse_alternative(text, line):
+    items_text, sep, expr = text.partition('=')
+    items = []
+    pos = 0
+    items_text = items_text.rstrip()
+    while pos != len(items_text):
+        m = TOKEN_RE.match(items_text, pos)
+        if not m:
+            raise GrammarError('line %d: unexpected "%s"' % (line, items_text[pos:].strip()))
+        if m.group(1) is not None:
+            if not re.match(r'^([a-z]+|-)$', m.group(1)):
+                raise GrammarError("line %d: '%s' is not a keyword" % (line, m.group(1)))
+            items.append(Item('keyword', m.group(1)))
+        elif m.group(2) is not None:
+            items.append(Item('space', '_'))
+        else:
+            items.append(Item('rule', m.group(3)))
+        pos = m.end()
+    if not items:
+        raise GrammarError('line %d: empty alternative' % line)
+
+    expr = expr.strip() if sep else None
+    if expr is not None and not EXPR_RE.match(expr):
+        raise GrammarError('line %d: invalid expression "%s"' % (line, expr))
+    if expr is None and len(items) > 1:
+        raise GrammarError('line %d: an alternative of several items needs an expression' % line)
+    return Alternative(items, expr, line)
+
+
+def parse(text):
+    """Parses a grammar description, returns the grammars in order."""
+    grammars = OrderedDict()
+    grammar = None
+    rule = None
+    comments = []
+    for line, raw in enumerate(text.splitlines(), 1):
+        stripped = raw.strip()
+        if stripped.startswith('#'):
+            comments.append(stripped[1:].strip())
+            continue
+        if not stripped:
+            comments = []
+            continue
+
+        m = re.match(r'^grammar\s+([a-z_][a-z0-9_]*)\s*(?::\s*([a-z_][a-z0-9_]*))?$', stripped)
+        if m:
+            name, base = m.groups()
+            if name in grammars:
+                raise GrammarError('line %d: grammar %s is already defined' % (line, name))
+            if base is not None and base not in grammars:
+                raise GrammarError('line %d: unknown base grammar %s' % (line, base))
+            grammar = Grammar(name, base, ' '.join(comments))
+            if base is not None:
+                grammar.rules.update(grammars[base].rules)
+            grammars[name] = grammar
+            rule = None
+        elif grammar is None:
+            raise GrammarError('line %d: a rule outside of a grammar' % line)
+        elif stripped.startswith('|'):
+            if rule is None:
+                raise GrammarError('line %d: alternatives without a rule' % line)
+            rule.alternatives += [parse_alternative(alt, line) for alt in stripped[1:].split('|')]
+        else:
+            m = re.match(r'^([A-Za-z][A-Za-z0-9]*)\s*->(.*)$', stripped)
+            if not m:
+                raise GrammarError('line %d: expected a rule' % line)
+            rule = Rule(m.group(1), line)
+            rule.alternatives = [parse_alternative(alt, line) for alt in m.group(2).split('|')]
+            grammar.rules[rule.name] = rule
+        comments = []
+
+    if not grammars:
+        raise GrammarError('no grammar is defined')
+    for grammar in grammars.values():
+        check(grammar)
+    return grammars
+
+
+def check(grammar):
+    """Checks the rules of `grammar`, which cannot be undefined nor recursive."""
+    if START_RULE not in grammar.rules:
+        raise GrammarError('grammar %s: no rule %s' % (grammar.name, START_RULE))
+    for rule in grammar.rules.values():
+        seen = set()
+        for alt in rule.alternatives:
+            if alt.items[0].kind == 'space':
+                raise GrammarError('line %d: an alternative cannot start with a Space' % alt.line)
+            key = tuple(item.key() for item in alt.items)
+            if key in seen:
+                raise GrammarError('line %d: duplicated alternative of %s' % (alt.line, rule.name))
+            seen.add(key)
+            for item in alt.items:
+                if item.kind == 'rule' and item.name not in grammar.rules:
+                    raise GrammarError('line %d: unknown rule %s in grammar %s' % (alt.line, item.name, grammar.name))
+            for ref in re.findall(r'\$(\d+)', alt.expr or ''):
+                i = int(ref)
+                if i < 1 or i > len(alt.items) or alt.items[i - 1].kind == 'space':
+                    raise GrammarError('line %d: $%d is not the value of an item' % (alt.line, i))
+    rules_in_order(grammar)
+
+
+def rules_in_order(grammar):
+    """Returns the rules reachable from the start rule, each after those it uses."""
+    order = []
+    state = {}
+
+    def visit(name, path):
+        if state.get(name) == 'done':
+            return
+        if state.get(name) == 'visiting':
+            raise GrammarError('grammar %s: recursive rule %s' % (grammar.name, ' -> '.join(path + [name])))
+        state[name] = 'visiting'
+        for alt in grammar.rules[name].alternatives:
+            for item in alt.items:
+                if item.kind == 'rule':
+                    visit(item.name, path + [name])
+        state[name] = 'done'
+        order.append(grammar.rules[name])
+
+    visit(START_RULE, [])
+    return order
+
+
+class Node(object):
+    """A node of the prefix tree of the alternatives of a rule."""
+
+    def __init__(self):
+        self.children = OrderedDict()   # item key -> (item, Node)
+        self.complete = []              # alternatives that end at this node
+
+
+def prefix_tree(rule):
+    root = Node()
+    for alt in rule.alternatives:
+        node = root
+        for item in alt.items:
+            if item.key() not in node.children:
+                node.children[item.key()] = (item, Node())
+            node = node.children[item.key()][1]
+        node.complete.append(alt)
+    return root
+
+
+def measure(grammar):
+    """
+    Returns, for each rule, the maximum size of its matches in tokens, and the
+    maximum number of tokens its matcher may examine.
+    """
+    size = {}
+    reach = {}
+    for rule in rules_in_order(grammar):
+        def walk(node, offset):
+            longest, examined = 0, 0
+            if node.complete:
+                longest = offset
+            for item, child in node.children.values():
+                item_size = size[item.name] if item.kind == 'rule' else 1
+                item_reach = reach[item.name] if item.kind == 'rule' else 1
+                child_size, child_reach = walk(child, offset + item_size)
+                longest = max(longest, child_size)
+                examined = max(examined, offset + item_reach, child_reach)
+            return longest, examined
+        size[rule.name], reach[rule.name] = walk(prefix_tree(rule), 0)
+    return size, reach
+
+
+def first_keywords(grammar):
+    """Returns the keywords that may start a match of the grammar."""
+    def first(name):
+        keywords = set()
+        for alt in grammar.rules[name].alternatives:
+            item = alt.items[0]
+            keywords |= first(item.name) if item.kind == 'rule' else {item.name}
+        return keywords
+    return first(START_RULE)
+
+
+def enumerator(name):
+    return Item('keyword', name).enumerator()
+
+
+def value(alt, refs):
+    """Returns the C++ expression of the value of `alt`, given the expression of the value of each item."""
+    if alt.expr is None:
+        return refs[0]
+    return re.sub(r'\$(\d+)', lambda m: refs[int(m.group(1)) - 1], alt.expr)
+
+
+def emit_keyword_rule(rule, out):
+    """Emits a rule whose alternatives are single keywords as a switch."""
+    out.append('        probe_t<Stats> at{ stats, grammar_rule_e::%s };' % rule.name)
+    out.append('        auto k = at(it0).keyword;')
+    out.append('        switch (k) {')
+    plain = [alt for alt in rule.alternatives if alt.expr is None]
+    for alt in plain:
+        out.append('        case %s:' % alt.items[0].enumerator())
+    if plain:
+        out.append('            return { 1, keyword_value(k) };')
+    for alt in rule.alternatives:
+        if alt.expr is not None:
+            out.append('        case %s:' % alt.items[0].enumerator())
+            out.append('            return { 1, %s };' % value(alt, ['keyword_value(k)']))
+    out.append('        default:')
+    out.append('            return {};')
+    out.append('        }')
+
+
+def emit_node(node, depth, refs, out, indent):
+    """Emits the matching of the children of `node`, whose items start at it<depth>."""
+    pad = ' ' * indent
+    it = 'it%d' % depth
+    for alt in node.complete:
+        out.append(pad + 'keep_longest(best, it0, %s, %s);' % (it, value(alt, refs)))
+
+    # the token is examined once for all the keywords and Spaces that may follow
+    if any(item.kind != 'rule' for item, _ in node.children.values()):
+        out.append(pad + 'const token_record_t& t%d = at(%s);' % (depth, it))
+
+    next_it = 'it%d' % (depth + 1)
+    for item, child in node.children.values():
+        if item.kind == 'keyword':
+            out.append(pad + 'if (t%d.keyword == %s) {' % (depth, item.enumerator()))
+            out.append(pad + '    auto %s = %s + 1;' % (next_it, it))
+            ref = 'keyword_value(%s)' % item.enumerator()
+        elif item.kind == 'space':
+            out.append(pad + 'if (t%d.is_space()) {' % depth)
+            out.append(pad + '    auto %s = %s + 1;' % (next_it, it))
+            ref = '0'
+        else:
+            out.append(pad + 'if (match_t m%d = rule_%s(%s, stats)) {' % (depth + 1, item.name, it))
+            out.append(pad + '    auto %s = %s + m%d.size;' % (next_it, it, depth + 1))
+            ref = 'm%d.num' % (depth + 1)
+        emit_node(child, depth + 1, refs + [ref], out, indent + 4)
+        out.append(pad + '}')
+
+
+def emit_rule(rule, out):
+    out.append('    /**')
+    out.append('     * Matches the rule:')
+    out.append('     * ' + rule.text())
+    out.append('     */')
+    out.append('    template<typename Stats>')
+    out.append('    match_t rule_%s(const token_record_t* it0, Stats& stats) noexcept' % rule.name)
+    out.append('    {')
+    if all(len(alt.items) == 1 and alt.items[0].kind == 'keyword' for alt in rule.alternatives):
+        emit_keyword_rule(rule, out)
+    else:
+        tree = prefix_tree(rule)
+        if any(item.kind != 'rule' for item in iter_items(tree)):
+            out.append('        probe_t<Stats> at{ stats, grammar_rule_e::%s };' % rule.name)
+        out.append('        match_t best = {};')
+        emit_node(tree, 0, [], out, 8)
+        out.append('        return best;')
+    out.append('    }')
+    out.append('')
+
+
+def iter_items(node):
+    for item, child in node.children.values():
+        yield item
+        for sub in iter_items(child):
+            yield sub
+
+
+def generate_header(grammars, default, path):
+    lookahead = max(measure(g)[1][START_RULE] for g in grammars.values())
+    starts = set()
+    for g in grammars.values():
+        starts |= first_keywords(g)
+
+    out = []
+    out.append('#ifndef ' + HEADER_GUARD)
+    out.append('#define ' + HEADER_GUARD)
+    out.append('')
+    out.append('// Generated by tools/grammar_gen.py from %s, do not edit.' % path)
+    out.append('')
+    out.append('#include "core/keyword.h"')
+    out.append('')
+    out.append('#include <cstdint>')
+    out.append('#include <cstddef>')
+    out.append('')
+    out.append('namespace core {')
+    out.append('')
+    out.append('    /// Variants of the cardinal numbers grammar, see match_cardinal_number().')
+    out.append('    enum class grammar_variant_e : std::uint8_t {')
+    for g in grammars.values():
+        if g.doc:
+            out.append('        /// ' + g.doc)
+        out.append('        %s,' % g.name)
+    out.append('        count_      //!< Number of variants, not a variant.')
+    out.append('    };')
+    out.append('')
+    out.append('    /// Variant matched unless another one is selected, chosen at build time.')
+    out.append('    constexpr grammar_variant_e default_grammar_variant = grammar_variant_e::%s;' % default)
+    out.append('')
+    out.append('    /// Maximum number of tokens the generated matcher of any variant may examine.')
+    out.append('    constexpr std::size_t grammar_variants_lookahead = %d;' % lookahead)
+    out.append('')
+    out.append('    /// Returns whether `k` may start a textual number in any variant.')
+    out.append('    inline bool grammar_starts_number(keyword_e k) noexcept')
+    out.append('    {')
+    out.append('        switch (k) {')
+    for k in sorted(starts, key=lambda name: keyword_order.get(name, len(keyword_order))):
+        out.append('        case %s:' % enumerator(k))
+    out.append('            return true;')
+    out.append('        default:')
+    out.append('            return false;')
+    out.append('        }')
+    out.append('    }')
+    out.append('')
+    out.append('}')
+    out.append('')
+    out.append('#endif // ' + HEADER_GUARD)
+    return '\n'.join(out) + '\n'
+
+
+def generate_source(grammars, path):
+    out = []
+    out.append('// Generated by tools/grammar_gen.py from %s, do not edit.' % path)
+    out.append('// Included by grammar.cpp within its unnamed namespace, after probe_t and keep_longest().')
+    out.append('')
+    for g in grammars.values():
+        out.append('namespace %s_rules {' % g.name)
+        out.append('')
+        for rule in rules_in_order(g):
+            emit_rule(rule, out)
+        out.append('}')
+        out.append('')
+
+    out.append('/// Matches CardNum with the generated matcher of `variant`.')
+    out.append('template<typename Stats>')
+    out.append('match_t match_variant(const token_record_t* it, grammar_variant_e variant, Stats& stats) noexcept')
+    out.append('{')
+    out.append('    switch (variant) {')
+    for g in grammars.values():
+        out.append('    case grammar_variant_e::%s: return %s_rules::rule_%s(it, stats);' % (g.name, g.name, START_RULE))
+    out.append('    case grammar_variant_e::count_: break;')
+    out.append('    }')
+    out.append('    return {};')
+    out.append('}')
+    out.append('')
+    out.append('/// Names of the variants, as in the grammar description.')
+    out.append('const char* const variant_names[] = {')
+    for g in grammars.values():
+        out.append('    "%s",' % g.name)
+    out.append('};')
+    return '\n'.join(out) + '\n'
+
+
+# order of the keywords in keyword_e, so that the generated cases are sorted
+keyword_order = {name: i for i, name in enumerate(
+    'zero one two three four five six seven eight nine ten eleven twelve thirteen fourteen fifteen sixteen '
+    'seventeen eighteen nineteen twenty thirty forty fifty sixty seventy eighty ninety hundred thousand million '
+    'a and -'.split())}
+
+
+def write_if_changed(path, text):
+    # keep the timestamp of unchanged outputs, so that their dependents are not rebuilt
+    try:
+        with open(path) as f:
+            if f.read() == text:
+                return
+    except IOError:
+        pass
+    with open(path, 'w') as f:
+        f.write(text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('grammar', help='grammar description')
+    parser.add_argument('--header', required=True, help='generated header, core/grammar_variants.h')
+    parser.add_argument('--source', required=True, help='generated source, grammar_rules.inc')
+    parser.add_argument('--default', help='variant matched by default, the first one if not given')
+    parser.add_argument('--name', help='path of the description written in the outputs')
+    args = parser.parse_args()
+
+    with open(args.grammar) as f:
+        text = f.read()
+    try:
+        grammars = parse(text)
+        default = args.default or next(iter(grammars))
+        if default not in grammars:
+            raise GrammarError('unknown default grammar %s, the grammars are: %s' % (default, ', '.join(grammars)))
+    except GrammarError as e:
+        sys.stderr.write('%s: %s\n' % (args.grammar, e))
+        return 1
+
+    name = args.name or args.grammar
+    write_if_changed(args.header, generate_header(grammars, default, name))
+    write_if_changed(args.source, generate_source(grammars, name))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())